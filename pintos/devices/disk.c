@@ -32,6 +32,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +48,15 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+
+/* Largest DRQ block we ask for with SET MULTIPLE MODE, and the
+   largest sector count we put in a single command (the Sector
+   Count register is 8 bits wide and 0 means 256). */
+#define MAX_MULTIPLE 16
+#define MAX_XFER_SECTORS 256
 
 /* An ATA device. */
 struct disk {
@@ -59,6 +69,9 @@ struct disk {
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	long long cmd_cnt;          /* Number of read/write commands issued. */
+	unsigned multiple;          /* Sectors per DRQ block, 1 if READ/WRITE
+								   MULTIPLE is not in use. */
 };
 
 /* An ATA channel (aka controller).
@@ -84,7 +97,8 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
+static void set_multiple_mode (struct disk *, const uint16_t id[]);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -133,7 +147,8 @@ disk_init (void) {
 			d->is_ata = false;
 			d->capacity = 0;
 
-			d->read_cnt = d->write_cnt = 0;
+			d->read_cnt = d->write_cnt = d->cmd_cnt = 0;
+			d->multiple = 1;
 		}
 
 		/* Register interrupt handler. */
@@ -167,8 +182,8 @@ disk_print_stats (void) {
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
 			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+				printf ("%s: %lld reads, %lld writes, %lld commands\n",
+						d->name, d->read_cnt, d->write_cnt, d->cmd_cnt);
 		}
 	}
 }
@@ -209,47 +224,104 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	disk_read_multiple (d, sec_no, 1, buffer);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, 1, buffer);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  Up to MAX_XFER_SECTORS sectors go out as a single
+   command, and the device interrupts once per DRQ block rather
+   than once per sector when READ MULTIPLE is enabled.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer) {
 	struct channel *c;
+	uint8_t *p = buffer;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	while (cnt > 0) {
+		size_t xfer = cnt < MAX_XFER_SECTORS ? cnt : MAX_XFER_SECTORS;
+		size_t done;
+
+		select_sector (d, sec_no, xfer);
+		issue_pio_command (c, d->multiple > 1
+				? CMD_READ_MULTIPLE : CMD_READ_SECTOR_RETRY);
+		for (done = 0; done < xfer; ) {
+			size_t blk = xfer - done < d->multiple ? xfer - done : d->multiple;
+
+			sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) done);
+			for (; blk > 0; blk--, done++, p += DISK_SECTOR_SIZE)
+				input_sector (c, p);
+		}
+		d->read_cnt += xfer;
+		d->cmd_cnt++;
+		sec_no += xfer;
+		cnt -= xfer;
+	}
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   Returns after the disk has acknowledged receiving the data.
+   Batches like disk_read_multiple().
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		const void *buffer) {
 	struct channel *c;
+	const uint8_t *p = buffer;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	while (cnt > 0) {
+		size_t xfer = cnt < MAX_XFER_SECTORS ? cnt : MAX_XFER_SECTORS;
+		size_t done;
+
+		select_sector (d, sec_no, xfer);
+		issue_pio_command (c, d->multiple > 1
+				? CMD_WRITE_MULTIPLE : CMD_WRITE_SECTOR_RETRY);
+		for (done = 0; done < xfer; ) {
+			size_t blk = xfer - done < d->multiple ? xfer - done : d->multiple;
+
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) done);
+			for (; blk > 0; blk--, done++, p += DISK_SECTOR_SIZE)
+				output_sector (c, p);
+			sema_down (&c->completion_wait);
+		}
+		d->write_cnt += xfer;
+		d->cmd_cnt++;
+		sec_no += xfer;
+		cnt -= xfer;
+	}
 	lock_release (&c->lock);
 }
-
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -364,6 +436,8 @@ identify_ata_device (struct disk *d) {
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	set_multiple_mode (d, id);
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -382,6 +456,31 @@ identify_ata_device (struct disk *d) {
 	printf ("\"\n");
 }
 
+/* Enables READ/WRITE MULTIPLE on disk D if its IDENTIFY DEVICE
+   data ID says it supports them, so that one interrupt covers a
+   block of sectors.  Leaves D->multiple at 1 otherwise. */
+static void
+set_multiple_mode (struct disk *d, const uint16_t id[]) {
+	struct channel *c = d->channel;
+	unsigned max = id[47] & 0xff;
+	unsigned blk = 1;
+
+	/* The block size must be a power of two no larger than the
+	   maximum the device reports. */
+	while (blk * 2 <= max && blk * 2 <= MAX_MULTIPLE)
+		blk *= 2;
+	if (blk == 1)
+		return;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), blk);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	if (wait_while_busy (d) || (inb (reg_status (c)) & STA_ERR) != 0)
+		return;
+	d->multiple = blk;
+}
+
 /* Prints STRING, which consists of SIZE bytes in a funky format:
    each pair of bytes is in reverse order.  Does not print
    trailing whitespace and/or nulls. */
@@ -402,17 +501,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= MAX_XFER_SECTORS);
+	ASSERT (sec_no + cnt <= d->capacity);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt & 0xff);   /* 0 means 256. */
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -20,65 +20,168 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/* Guards TICKS, so that timer_ticks() reads it without turning
+   interrupts off. */
+static struct seqlock ticks_seq;
+
+/* The PIT is run one-shot: loaded with one count at a time,
+   ending at the next tick or sooner for a sub-tick sleeper.  Time
+   is kept by counting PIT cycles, read back from the counter.
+
+   -tickless: the count ends at the next deadline instead of the
+   next tick: the first sleeping thread's wakeup or the end of the
+   running thread's time slice, or under the MLFQS its next
+   priority update.  The idle CPU is interrupted only when a
+   sleeper is due, or when the 16-bit counter would otherwise wrap
+   (about 18 times a second, a limit of the PIT itself), and
+   timer_ticks() reads the counter to stay exact between
+   interrupts. */
+bool timer_tickless;
+
+/* PIT input clock, and its cycles per timer tick. */
+#define PIT_HZ 1193180
+#define PIT_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Shortest count loaded, so that a deadline already passed still
+   leaves time to return from the interrupt handler. */
+#define PIT_MIN_COUNT 64
+
+#define NSEC_PER_SEC 1000000000
+
+/* Sleeps shorter than the shortest count spin instead of
+   blocking. */
+#define SPIN_NS ((int64_t)PIT_MIN_COUNT * NSEC_PER_SEC / PIT_HZ)
+
+/* PIT state.  Interrupts must be off to use these. */
+static uint64_t pit_cycles;				/* PIT cycles since boot. */
+static uint16_t pit_last;				/* Counter as of PIT_CYCLES. */
+static bool pit_armed;					/* Count loaded, not yet expired. */
+
+/* Timer wheel of pending ktimers.  Wheel 0 has a slot for each of
+   the next WHEEL_SIZE ticks; a slot of wheel L spans WHEEL_SIZE
+   slots of wheel L - 1.  Adding a timer puts it straight into the
+   slot for its deadline on the lowest wheel that reaches that far.
+   Each time wheel 0 wraps, the next slot of wheel 1 is emptied back
+   into wheel 0, and likewise up the wheels, so a timer moves at
+   most WHEEL_LEVELS - 1 times before it fires.  Interrupts must be
+   off to use these. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static int64_t wheel_tick;				/* Next tick to run. */
+static size_t wheel_cnt;				/* Pending timers. */
+
+/* TSC clocksource, set by timer_calibrate().  timer_ns() is
+   NS_BASE plus the TSC cycles since TSC_BASE, scaled by
+   TSC_MULT / 2**32 nanoseconds per cycle. */
+static uint64_t tsc_hz;					/* TSC cycles per second. */
+static uint64_t tsc_mult;
+static uint64_t tsc_base;
+static int64_t ns_base;
+
+/* A thread in a sub-tick sleep. */
+struct hr_sleeper
+{
+	struct list_elem elem;				/* Element in hr_list. */
+	int64_t deadline;					/* timer_ns() to wake at. */
+	struct thread *thread;				/* Sleeping thread. */
+};
+
+/* Sub-tick sleepers, soonest deadline first.  The PIT count is
+   cut short to end at the first one.  Interrupts must be off to
+   use this. */
+static struct list hr_list;
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops(unsigned loops);
-static void busy_wait(int64_t loops);
+static void wheel_insert(struct ktimer *);
+static void wheel_run(int64_t now);
+static void hr_run(void);
+static void hr_sleep(int64_t deadline);
+static bool hr_less(const struct list_elem *, const struct list_elem *, void *aux);
+static void pit_load(uint16_t count);
+static void pit_sync(void);
+static uint64_t rdtsc(void);
 static void real_time_sleep(int64_t num, int32_t denom);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
-   interrupt PIT_FREQ times per second, and registers the
+   interrupt at the end of the first tick, and registers the
    corresponding interrupt. */
 void timer_init(void)
 {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	pit_load(PIT_PER_TICK);
 
-	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb(0x40, count & 0xff);
-	outb(0x40, count >> 8);
+	for (int l = 0; l < WHEEL_LEVELS; l++)
+		for (int i = 0; i < WHEEL_SIZE; i++)
+			list_init(&wheel[l][i]);
+	list_init(&hr_list);
 
+	seq_init(&ticks_seq);
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates the TSC against the PIT, for timer_ns(). */
 void timer_calibrate(void)
 {
-	unsigned high_bit, test_bit;
+	enum intr_level old_level;
+	uint64_t pit_start, pit_end, tsc_start, tsc_end;
 
 	ASSERT(intr_get_level() == INTR_ON);
 	printf("Calibrating timer...  ");
 
-	/* Approximate loops_per_tick as the largest power-of-two
-	   still less than one timer tick. */
-	loops_per_tick = 1u << 10;
-	while (!too_many_loops(loops_per_tick << 1))
+	/* Count TSC cycles over a tenth of a second of PIT cycles,
+	   reading both clocks together at each end.  The PIT is read
+	   directly, not through TICKS, which under -tickless only
+	   advances at interrupts.  Interrupts stay on in between so
+	   the counter is synced at least once per wrap. */
+	old_level = intr_disable();
+	pit_sync();
+	pit_start = pit_cycles;
+	tsc_start = rdtsc();
+	intr_set_level(old_level);
+
+	do
 	{
-		loops_per_tick <<= 1;
-		ASSERT(loops_per_tick != 0);
-	}
+		barrier();
+		old_level = intr_disable();
+		pit_sync();
+		pit_end = pit_cycles;
+		tsc_end = rdtsc();
+		intr_set_level(old_level);
+	} while (pit_end - pit_start < PIT_HZ / 10);
 
-	/* Refine the next 8 bits of loops_per_tick. */
-	high_bit = loops_per_tick;
-	for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-		if (!too_many_loops(high_bit | test_bit))
-			loops_per_tick |= test_bit;
+	old_level = intr_disable();
+	tsc_hz = (tsc_end - tsc_start) * PIT_HZ / (pit_end - pit_start);
+	tsc_mult = ((uint64_t)NSEC_PER_SEC << 32) / tsc_hz;
+	tsc_base = tsc_end;
+	ns_base = pit_end * NSEC_PER_SEC / PIT_HZ;
+	intr_set_level(old_level);
 
-	printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+	printf("%'" PRIu64 " TSC cycles/s.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks(void)
 {
-	enum intr_level old_level = intr_disable();
-	int64_t t = ticks;
-	intr_set_level(old_level);
-	barrier();
+	unsigned seq;
+	int64_t t;
+
+	if (timer_tickless)
+	{
+		enum intr_level old_level = intr_disable();
+
+		pit_sync();
+		t = pit_cycles / PIT_PER_TICK;
+		intr_set_level(old_level);
+		return t;
+	}
+
+	do
+	{
+		seq = seq_read_begin(&ticks_seq);
+		t = ticks;
+	} while (seq_read_retry(&ticks_seq, seq));
 	return t;
 }
 
@@ -90,6 +193,18 @@ timer_elapsed(int64_t then)
 	return timer_ticks() - then;
 }
 
+/* Returns the nanoseconds since the OS booted, from the TSC.
+   Monotonic, and cheap enough for instrumentation: it neither
+   turns interrupts off nor touches the PIT.  Has only tick
+   resolution until timer_calibrate() runs. */
+int64_t
+timer_ns(void)
+{
+	if (tsc_mult == 0)
+		return timer_ticks() * (NSEC_PER_SEC / TIMER_FREQ);
+	return ns_base + (int64_t)(((unsigned __int128)(rdtsc() - tsc_base) * tsc_mult) >> 32);
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void timer_sleep(int64_t ticks)
 {
@@ -102,10 +217,6 @@ void timer_sleep(int64_t ticks)
 	struct thread *t = thread_current();
 	t->wakeup_tick = wakeup_tick;
 	thread_sleep();
-	// int64_t start = timer_ticks();
-	// ASSERT(intr_get_level() == INTR_ON);
-	// while (timer_elapsed(start) < ticks)
-	// thread_yield();
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -136,69 +247,286 @@ void timer_print_stats(void)
 static void
 timer_interrupt(struct intr_frame *args UNUSED)
 {
-	awake_sleep_threads(++ticks);
-	thread_tick();
+	/* Wake sub-tick sleepers, run a tick's work for every tick
+	   since the last interrupt (none if this one came between
+	   ticks), then load the next deadline.  The ticks are run
+	   before the wheel wakes anyone, so the MLFQS counts the ready
+	   threads each skipped tick actually had. */
+	int64_t then = ticks;
+
+	pit_armed = false;
+	pit_sync();
+	seq_write_begin(&ticks_seq);
+	ticks = pit_cycles / PIT_PER_TICK;
+	seq_write_end(&ticks_seq);
+	hr_run();
+	for (; then < ticks; then++)
+		thread_tick(then + 1);
+	wheel_run(ticks);
+	timer_set_deadline(timer_tickless ? thread_next_deadline(ticks) : ticks + 1);
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
-static bool
-too_many_loops(unsigned loops)
+/* Initializes TIMER to call FUNC (AUX) once added. */
+void ktimer_init(struct ktimer *timer, ktimer_func *func, void *aux)
 {
-	/* Wait for a timer tick. */
-	int64_t start = ticks;
-	while (ticks == start)
-		barrier();
+	ASSERT(timer != NULL);
+	ASSERT(func != NULL);
 
-	/* Run LOOPS loops. */
-	start = ticks;
-	busy_wait(loops);
+	timer->func = func;
+	timer->aux = aux;
+	timer->pending = false;
+}
+
+/* Arranges for TIMER to fire at the start of tick DEADLINE, or at
+   the next tick if DEADLINE has passed.  TIMER must not be
+   pending.  May be called from an interrupt handler. */
+void ktimer_add(struct ktimer *timer, int64_t deadline)
+{
+	enum intr_level old_level = intr_disable();
 
-	/* If the tick count changed, we iterated too long. */
-	barrier();
-	return start != ticks;
+	ASSERT(!timer->pending);
+
+	timer->deadline = deadline;
+	timer->pending = true;
+	wheel_insert(timer);
+	wheel_cnt++;
+	if (timer_tickless)
+		timer_set_deadline(deadline);
+	intr_set_level(old_level);
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
+/* Stops TIMER from firing.  Returns true if it was pending. */
+bool ktimer_cancel(struct ktimer *timer)
+{
+	enum intr_level old_level = intr_disable();
+	bool pending = timer->pending;
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE
-busy_wait(int64_t loops)
+	if (pending)
+	{
+		list_remove(&timer->elem);
+		timer->pending = false;
+		wheel_cnt--;
+	}
+	intr_set_level(old_level);
+	return pending;
+}
+
+/* Returns the first tick at which the timer wheel has work to do:
+   a timer fires, or a higher wheel is emptied into wheel 0.
+   Returns INT64_MAX if no timer is pending.  Interrupts must be
+   off. */
+int64_t timer_next_event(void)
+{
+	int64_t t;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (wheel_cnt == 0)
+		return INT64_MAX;
+	for (t = wheel_tick; (t + 1) % WHEEL_SIZE != 0; t++)
+		if (!list_empty(&wheel[0][t % WHEEL_SIZE]))
+			return t;
+	return list_empty(&wheel[0][t % WHEEL_SIZE]) ? t + 1 : t;
+}
+
+/* Files TIMER in the wheel slot for its deadline. */
+static void
+wheel_insert(struct ktimer *timer)
 {
-	while (loops-- > 0)
+	int64_t deadline = timer->deadline > wheel_tick ? timer->deadline : wheel_tick;
+	int64_t delta = deadline - wheel_tick;
+	int level = 0;
+
+	while (level < WHEEL_LEVELS - 1 && delta >= (int64_t)1 << (WHEEL_BITS * (level + 1)))
+		level++;
+
+	/* Beyond the top wheel, park at its far end.  The timer is
+	   filed again, with its real deadline, when that slot is
+	   emptied. */
+	if (delta >= (int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+		deadline = wheel_tick + ((int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+	list_push_back(&wheel[level][(deadline >> (WHEEL_BITS * level)) % WHEEL_SIZE],
+				   &timer->elem);
+}
+
+/* Fires every pending timer whose deadline is at or before NOW. */
+static void
+wheel_run(int64_t now)
+{
+	while (wheel_tick <= now)
+	{
+		struct list due;
+
+		/* At the start of each span of a higher wheel, move that
+		   span's timers down. */
+		for (int level = 1; level < WHEEL_LEVELS; level++)
+		{
+			struct list *slot;
+
+			if (wheel_tick % ((int64_t)1 << (WHEEL_BITS * level)) != 0)
+				break;
+			slot = &wheel[level][(wheel_tick >> (WHEEL_BITS * level)) % WHEEL_SIZE];
+			while (!list_empty(slot))
+				wheel_insert(list_entry(list_pop_front(slot), struct ktimer, elem));
+		}
+
+		/* Take this tick's timers before running any, so that one
+		   added again for a passed deadline waits for the next
+		   tick. */
+		list_init(&due);
+		while (!list_empty(&wheel[0][wheel_tick % WHEEL_SIZE]))
+			list_push_back(&due, list_pop_front(&wheel[0][wheel_tick % WHEEL_SIZE]));
+		wheel_tick++;
+
+		while (!list_empty(&due))
+		{
+			struct ktimer *timer = list_entry(list_pop_front(&due), struct ktimer, elem);
+
+			timer->pending = false;
+			wheel_cnt--;
+			timer->func(timer->aux);
+		}
+	}
+}
+
+/* Makes the timer interrupt no later than the start of tick
+   DEADLINE, or the first sub-tick sleeper's deadline, or as close
+   to them as the counter allows.  Keeps an earlier count already
+   loaded.  Interrupts must be off. */
+void timer_set_deadline(int64_t deadline)
+{
+	uint64_t target;
+	uint64_t count = UINT16_MAX;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	pit_sync();
+	if (deadline - (int64_t)(pit_cycles / PIT_PER_TICK) <= UINT16_MAX / PIT_PER_TICK + 1)
+	{
+		target = deadline * PIT_PER_TICK;
+		count = target > pit_cycles ? target - pit_cycles : 0;
+	}
+	if (!list_empty(&hr_list))
+	{
+		/* Round up, so as not to interrupt before the sleeper is
+		   due. */
+		struct hr_sleeper *s = list_entry(list_front(&hr_list), struct hr_sleeper, elem);
+		int64_t left = s->deadline - timer_ns();
+
+		if (left < NSEC_PER_SEC)
+		{
+			target = left > 0 ? ((uint64_t)left * PIT_HZ + NSEC_PER_SEC - 1) / NSEC_PER_SEC : 0;
+			if (target < count)
+				count = target;
+		}
+	}
+	if (count < PIT_MIN_COUNT)
+		count = PIT_MIN_COUNT;
+	else if (count > UINT16_MAX)
+		count = UINT16_MAX;
+	if (!pit_armed || pit_last > count)
+		pit_load(count);
+}
+
+/* Wakes the sub-tick sleepers that are due, or so nearly due
+   that no count could be shorter. */
+static void
+hr_run(void)
+{
+	int64_t now = timer_ns();
+
+	while (!list_empty(&hr_list))
+	{
+		struct hr_sleeper *s = list_entry(list_front(&hr_list), struct hr_sleeper, elem);
+
+		if (s->deadline - now >= SPIN_NS)
+			break;
+		list_pop_front(&hr_list);
+		thread_unblock(s->thread);
+	}
+}
+
+/* Sleeps until timer_ns() reaches DEADLINE, less than a tick
+   away, blocking until a one-shot count ends at it.  The last
+   stretch, shorter than any count, is spun on the TSC. */
+static void
+hr_sleep(int64_t deadline)
+{
+	struct hr_sleeper s;
+
+	while (deadline - timer_ns() >= SPIN_NS)
+	{
+		enum intr_level old_level = intr_disable();
+
+		s.deadline = deadline;
+		s.thread = thread_current();
+		list_insert_ordered(&hr_list, &s.elem, hr_less, NULL);
+		timer_set_deadline(INT64_MAX);
+		thread_block();
+		intr_set_level(old_level);
+	}
+	while (timer_ns() < deadline)
 		barrier();
 }
 
-/* Sleep for approximately NUM/DENOM seconds. */
+/* Orders sub-tick sleepers by deadline. */
+static bool
+hr_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct hr_sleeper, elem)->deadline < list_entry(b, struct hr_sleeper, elem)->deadline;
+}
+
+/* Loads COUNT into the PIT in one-shot mode.  Interrupts must be
+   off, and PIT_CYCLES up to date. */
 static void
-real_time_sleep(int64_t num, int32_t denom)
+pit_load(uint16_t count)
 {
-	/* Convert NUM/DENOM seconds into timer ticks, rounding down.
+	outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
+	pit_last = count;
+	pit_armed = true;
+}
 
-	   (NUM / DENOM) s
-	   ---------------------- = NUM * TIMER_FREQ / DENOM ticks.
-	   1 s / TIMER_FREQ ticks
-	   */
+/* Adds the PIT cycles since the last call to PIT_CYCLES.  After
+   reaching zero the counter keeps counting down from 0xffff, so
+   the difference is right modulo 2**16 as long as calls are less
+   than one wrap apart.  Interrupts must be off. */
+static void
+pit_sync(void)
+{
+	uint16_t now;
+
+	outb(0x43, 0x00); /* CW: latch counter 0. */
+	now = inb(0x40);
+	now |= inb(0x40) << 8;
+	pit_cycles += (uint16_t)(pit_last - now);
+	pit_last = now;
+}
+
+/* Reads the CPU's time-stamp counter. */
+static uint64_t
+rdtsc(void)
+{
+	uint32_t lo, hi;
+
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Sleep for approximately NUM/DENOM seconds, and at least that
+   long.  Whole ticks are slept on the timer wheel, rounding down,
+   and the rest until a one-shot count ends at the deadline, so the
+   CPU is yielded to other threads either way. */
+static void
+real_time_sleep(int64_t num, int32_t denom)
+{
+	int64_t deadline = timer_ns() + num * (NSEC_PER_SEC / denom);
 	int64_t ticks = num * TIMER_FREQ / denom;
 
 	ASSERT(intr_get_level() == INTR_ON);
 	if (ticks > 0)
-	{
-		/* We're waiting for at least one full timer tick.  Use
-		   timer_sleep() because it will yield the CPU to other
-		   processes. */
 		timer_sleep(ticks);
-	}
-	else
-	{
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
-		ASSERT(denom % 1000 == 0);
-		busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
-	}
+	hr_sleep(deadline);
 }
@@ -1,15 +1,17 @@
 #include "filesys/directory.h"
+#include <hash.h>
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
 	struct inode *inode;                /* Backing store. */
-	off_t pos;                          /* Current position. */
+	off_t pos;                          /* Current position, in entries. */
 };
 
 /* A single directory entry. */
@@ -19,11 +21,315 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* On disk a directory is a header sector followed by a
+ * power-of-two number of buckets, one sector each.  A name lives
+ * in the bucket its hash selects or, if that bucket was full when
+ * it was added, in one of the buckets after it.  Lookups read one
+ * sector and stop there unless the bucket has overflowed.
+ *
+ * Growing builds the doubled table in the sectors past the current
+ * one and switches to it by rewriting the header, so the old table
+ * stays whole until the new one is complete.  It then moves the new
+ * table down to the front of the file, and the sectors past it are
+ * where the next growth builds. */
+#define DIR_MAGIC 0x44495248
+#define BUCKET_ENTRIES 25
+
+/* First sector of a directory. */
+struct dir_header {
+	unsigned magic;                     /* Magic number. */
+	uint32_t bucket_cnt;                /* Number of buckets. */
+	uint32_t entry_cnt;                 /* Entries in use. */
+	uint32_t first_bucket;              /* Buckets before the table. */
+	uint32_t unused[124];               /* Not used. */
+};
+
+/* One bucket of entries. */
+struct dir_bucket {
+	struct dir_entry entries[BUCKET_ENTRIES];
+	uint8_t used;                       /* Entries in use; full if 25. */
+	bool overflow;                      /* Has pushed an entry onward. */
+	uint8_t unused[10];                 /* Not used. */
+};
+
+/* Directory entry cache.  Remembers the result of recent name
+ * lookups, keyed by the directory's inode sector and the name,
+ * including names that were not found, so that repeated opens of
+ * the same name do no directory I/O.  dir_add and dir_remove keep
+ * it in step with the disk.
+ *
+ * Probes take no dcache lock: they walk the hash chains inside an
+ * RCU read-side critical section.  A dentry never changes once it is
+ * published, except for its referenced bit, which lookups set
+ * without any lock; a lost or late update only changes which entry
+ * is evicted next.  Updaters, serialized by dcache_lock, swap in a
+ * new dentry and free the old one only after synchronize_rcu().
+ *
+ * Entries are keyed by a directory's inode sector, so when a
+ * removed directory's sector is freed for reuse, dir_forget()
+ * drops everything cached under it. */
+#define DCACHE_SIZE 64
+#define DCACHE_BUCKETS 64
+
+/* A cached lookup result. */
+struct dentry {
+	struct dentry *next;                /* Next in hash chain. */
+	struct list_elem lru_elem;          /* Element in dcache_lru. */
+	bool referenced;                    /* Hit since last passed over;
+	                                       written racily by lookups. */
+	disk_sector_t parent;               /* Directory inode sector. */
+	char name[NAME_MAX + 1];            /* Name looked up. */
+	bool negative;                      /* NAME is not in PARENT. */
+	disk_sector_t inode_sector;         /* Otherwise, its inode. */
+};
+
+/* Outcome of a dentry cache probe. */
+enum dcache_result {
+	DCACHE_MISS,                        /* Nothing cached. */
+	DCACHE_HIT,                         /* Name exists. */
+	DCACHE_NEGATIVE                     /* Name known not to exist. */
+};
+
+static struct dentry *dcache[DCACHE_BUCKETS]; /* Hash chains. */
+static struct list dcache_lru;          /* Newest first. */
+static size_t dcache_cnt;               /* Entries in dcache. */
+static struct lock dcache_lock;         /* Serializes updaters. */
+
+/* Held for writing by directory updates and for reading by
+ * lookups, so that no lookup sees a table midway through an update
+ * or a grow, no stale result is cached, and a cached inode sector
+ * is still in use when it is opened.  Lookups of different names
+ * proceed together. */
+static struct rwlock dir_lock;
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	list_init (&dcache_lru);
+	dcache_cnt = 0;
+	lock_init (&dcache_lock);
+	rw_init (&dir_lock);
+}
+
+/* Returns the head of the hash chain for NAME in PARENT. */
+static struct dentry **
+dcache_bucket (disk_sector_t parent, const char *name) {
+	return &dcache[(hash_string (name) ^ hash_int (parent)) % DCACHE_BUCKETS];
+}
+
+/* Returns the link that points to the dentry for NAME in
+ * directory PARENT, or to the null pointer ending its chain.
+ * Must be called inside an RCU read-side critical section or
+ * with dcache_lock held. */
+static struct dentry **
+dcache_find (disk_sector_t parent, const char *name) {
+	struct dentry **link = dcache_bucket (parent, name);
+	struct dentry *d;
+
+	while ((d = rcu_dereference (*link)) != NULL
+			&& (d->parent != parent || strcmp (d->name, name)))
+		link = &d->next;
+	return link;
+}
+
+/* Looks NAME up in the cache for directory PARENT.  On a hit,
+ * stores the inode sector in *SECTORP. */
+static enum dcache_result
+dcache_lookup (disk_sector_t parent, const char *name,
+		disk_sector_t *sectorp) {
+	enum dcache_result result = DCACHE_MISS;
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return DCACHE_MISS;
+
+	rcu_read_lock ();
+	d = rcu_dereference (*dcache_find (parent, name));
+	if (d != NULL) {
+		d->referenced = true;
+		if (d->negative)
+			result = DCACHE_NEGATIVE;
+		else {
+			*sectorp = d->inode_sector;
+			result = DCACHE_HIT;
+		}
+	}
+	rcu_read_unlock ();
+	return result;
+}
+
+/* Unlinks and returns the least recently used dentry, passing
+ * over, once, each one hit since it was last passed over.  Must
+ * be called with dcache_lock held and the cache non-empty. */
+static struct dentry *
+dcache_evict (void) {
+	struct dentry *d;
+
+	for (size_t i = 0; ; i++) {
+		d = list_entry (list_pop_back (&dcache_lru), struct dentry, lru_elem);
+		if (!d->referenced || i == dcache_cnt)
+			break;
+		d->referenced = false;
+		list_push_front (&dcache_lru, &d->lru_elem);
+	}
+	*dcache_find (d->parent, d->name) = d->next;
+	dcache_cnt--;
+	return d;
+}
+
+/* Records that NAME in directory PARENT has its inode at
+ * INODE_SECTOR, or does not exist if NEGATIVE.  Evicts the least
+ * recently used entry once the cache is full. */
+static void
+dcache_put (disk_sector_t parent, const char *name, bool negative,
+		disk_sector_t inode_sector) {
+	struct dentry *d, *old, **link;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+	d = malloc (sizeof *d);
+	if (d == NULL)
+		return;
+	d->referenced = false;
+	d->parent = parent;
+	strlcpy (d->name, name, sizeof d->name);
+	d->negative = negative;
+	d->inode_sector = inode_sector;
+
+	lock_acquire (&dcache_lock);
+	link = dcache_find (parent, name);
+	old = *link;
+	if (old != NULL) {
+		/* Replace OLD in its place in the chain, so that a lookup
+		 * finds one or the other. */
+		list_remove (&old->lru_elem);
+		d->next = old->next;
+	} else {
+		if (dcache_cnt == DCACHE_SIZE) {
+			old = dcache_evict ();
+			link = dcache_find (parent, name);
+		}
+		d->next = *link;
+		dcache_cnt++;
+	}
+	rcu_assign_pointer (*link, d);
+	list_push_front (&dcache_lru, &d->lru_elem);
+	lock_release (&dcache_lock);
+
+	if (old != NULL) {
+		synchronize_rcu ();
+		free (old);
+	}
+}
+
+/* Drops every cached lookup in the directory whose inode is at
+ * SECTOR.  Called when a removed directory's inode is freed, before
+ * its sector can be reused. */
+void
+dir_forget (disk_sector_t sector) {
+	struct list dead;
+	struct dentry *d, **link;
+
+	list_init (&dead);
+	lock_acquire (&dcache_lock);
+	for (size_t i = 0; i < DCACHE_BUCKETS; i++)
+		for (link = &dcache[i]; (d = *link) != NULL; )
+			if (d->parent == sector) {
+				/* D->next stays as it is, for lookups still on D. */
+				rcu_assign_pointer (*link, d->next);
+				list_remove (&d->lru_elem);
+				list_push_back (&dead, &d->lru_elem);
+				dcache_cnt--;
+			} else
+				link = &d->next;
+	lock_release (&dcache_lock);
+
+	if (list_empty (&dead))
+		return;
+	synchronize_rcu ();
+	while (!list_empty (&dead))
+		free (list_entry (list_pop_front (&dead), struct dentry, lru_elem));
+}
+
+/* Byte offset of bucket IDX of the table described by H in the
+ * directory file. */
+static off_t
+bucket_ofs (const struct dir_header *h, size_t idx) {
+	return (off_t) (h->first_bucket + idx + 1) * DISK_SECTOR_SIZE;
+}
+
+/* Reads DIR's header into *H.  Returns false on a short read. */
+static bool
+read_header (const struct dir *dir, struct dir_header *h) {
+	return inode_read_at (dir->inode, h, sizeof *h, 0) == sizeof *h
+		&& h->magic == DIR_MAGIC;
+}
+
+/* Writes *H as DIR's header.  Returns false on a short write. */
+static bool
+write_header (struct dir *dir, const struct dir_header *h) {
+	return inode_write_at (dir->inode, h, sizeof *h, 0) == sizeof *h;
+}
+
+/* Reads bucket IDX of the table H of DIR into *B.  Returns false
+ * on a short read. */
+static bool
+read_bucket (const struct dir *dir, const struct dir_header *h, size_t idx,
+		struct dir_bucket *b) {
+	return inode_read_at (dir->inode, b, sizeof *b, bucket_ofs (h, idx))
+		== sizeof *b;
+}
+
+/* Writes *B to bucket IDX of the table H of DIR.  Returns false on
+ * a short write. */
+static bool
+write_bucket (struct dir *dir, const struct dir_header *h, size_t idx,
+		const struct dir_bucket *b) {
+	return inode_write_at (dir->inode, b, sizeof *b, bucket_ofs (h, idx))
+		== sizeof *b;
+}
+
+/* Returns the bucket NAME hashes to in a table of BUCKET_CNT. */
+static size_t
+name_bucket (const char *name, size_t bucket_cnt) {
+	return hash_string (name) & (bucket_cnt - 1);
+}
+
+/* Writes empty buckets for the table described by H to the inode
+ * of DIR, growing it as needed.  Does not write the header. */
+static bool
+write_table (struct dir *dir, const struct dir_header *h) {
+	static struct dir_bucket empty;
+
+	for (size_t i = 0; i < h->bucket_cnt; i++)
+		if (!write_bucket (dir, h, i, &empty))
+			return false;
+	return true;
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
 dir_create (disk_sector_t sector, size_t entry_cnt) {
-	return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
+	struct dir_header h;
+	struct dir *dir;
+	bool success;
+
+	memset (&h, 0, sizeof h);
+	h.magic = DIR_MAGIC;
+	h.bucket_cnt = 1;
+	while (h.bucket_cnt * BUCKET_ENTRIES < entry_cnt)
+		h.bucket_cnt *= 2;
+
+	ASSERT (sizeof (struct dir_header) == DISK_SECTOR_SIZE);
+	ASSERT (sizeof (struct dir_bucket) == DISK_SECTOR_SIZE);
+
+	if (!inode_create (sector, bucket_ofs (&h, h.bucket_cnt)))
+		return false;
+	dir = dir_open (inode_open (sector));
+	success = dir != NULL && write_table (dir, &h) && write_header (dir, &h);
+	dir_close (dir);
+	return success;
 }
 
 /* Opens and returns the directory for the given INODE, of which
@@ -73,30 +379,113 @@ dir_get_inode (struct dir *dir) {
 
 /* Searches DIR for a file with the given NAME.
  * If successful, returns true, sets *EP to the directory entry
- * if EP is non-null, and sets *OFSP to the byte offset of the
- * directory entry if OFSP is non-null.
- * otherwise, returns false and ignores EP and OFSP. */
+ * if EP is non-null, and sets *BP and *SLOTP to the bucket and
+ * slot holding it if they are non-null.
+ * otherwise, returns false and ignores EP, BP and SLOTP. */
 static bool
 lookup (const struct dir *dir, const char *name,
-		struct dir_entry *ep, off_t *ofsp) {
-	struct dir_entry e;
-	size_t ofs;
+		struct dir_entry *ep, size_t *bp, size_t *slotp) {
+	struct dir_header h;
+	struct dir_bucket b;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (e.in_use && !strcmp (name, e.name)) {
-			if (ep != NULL)
-				*ep = e;
-			if (ofsp != NULL)
-				*ofsp = ofs;
-			return true;
+	if (!read_header (dir, &h))
+		return false;
+	size_t idx = name_bucket (name, h.bucket_cnt);
+	for (size_t n = 0; n < h.bucket_cnt && read_bucket (dir, &h, idx, &b); n++) {
+		for (size_t i = 0; i < BUCKET_ENTRIES; i++) {
+			struct dir_entry *e = &b.entries[i];
+			if (e->in_use && !strcmp (name, e->name)) {
+				if (ep != NULL)
+					*ep = *e;
+				if (bp != NULL)
+					*bp = idx;
+				if (slotp != NULL)
+					*slotp = i;
+				return true;
+			}
+		}
+		if (!b.overflow)
+			break;
+		idx = (idx + 1) & (h.bucket_cnt - 1);
+	}
+	return false;
+}
+
+/* Places entry E in the table of DIR described by *H, without
+ * checking for duplicates, and counts it in *H.  Buckets passed
+ * over because they are full are marked as overflowed.  Returns
+ * false if every bucket is full or on a disk error. */
+static bool
+insert (struct dir *dir, struct dir_header *h, const struct dir_entry *e) {
+	struct dir_bucket b;
+	size_t idx = name_bucket (e->name, h->bucket_cnt);
+
+	for (size_t n = 0; n < h->bucket_cnt; n++) {
+		if (!read_bucket (dir, h, idx, &b))
+			return false;
+		if (b.used < BUCKET_ENTRIES) {
+			for (size_t i = 0; i < BUCKET_ENTRIES; i++)
+				if (!b.entries[i].in_use) {
+					b.entries[i] = *e;
+					b.used++;
+					h->entry_cnt++;
+					return write_bucket (dir, h, idx, &b);
+				}
+		}
+		if (!b.overflow) {
+			b.overflow = true;
+			if (!write_bucket (dir, h, idx, &b))
+				return false;
 		}
+		idx = (idx + 1) & (h->bucket_cnt - 1);
+	}
 	return false;
 }
 
+/* Builds a table with twice the buckets of DIR's table *H in the
+ * sectors after it, rehashing every entry into it, switches DIR to
+ * it, and moves it to the front of the file.  On success updates
+ * *H to describe the new table.  If the file cannot grow to hold
+ * the new table, DIR keeps using the old one, unchanged. */
+static bool
+grow (struct dir *dir, struct dir_header *h) {
+	struct dir_header nh = *h, front;
+	struct dir_bucket b;
+
+	nh.first_bucket = h->first_bucket + h->bucket_cnt;
+	nh.bucket_cnt = h->bucket_cnt * 2;
+	nh.entry_cnt = 0;
+	if (!write_table (dir, &nh))
+		return false;
+	for (size_t i = 0; i < h->bucket_cnt; i++) {
+		if (!read_bucket (dir, h, i, &b))
+			return false;
+		for (size_t j = 0; j < BUCKET_ENTRIES; j++)
+			if (b.entries[j].in_use && !insert (dir, &nh, &b.entries[j]))
+				return false;
+	}
+	if (!write_header (dir, &nh))
+		return false;
+	*h = nh;
+
+	/* Copying in ascending order overwrites only buckets already
+	 * copied, and writes only sectors the file already has, so it
+	 * does not run out of space. */
+	front = nh;
+	front.first_bucket = 0;
+	for (size_t i = 0; i < nh.bucket_cnt; i++)
+		if (!read_bucket (dir, &nh, i, &b)
+				|| !write_bucket (dir, &front, i, &b))
+			return false;
+	if (!write_header (dir, &front))
+		return false;
+	*h = front;
+	return true;
+}
+
 /* Searches DIR for a file with the given NAME
  * and returns true if one exists, false otherwise.
  * On success, sets *INODE to an inode for the file, otherwise to
@@ -104,15 +493,34 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
+	disk_sector_t parent;
 	struct dir_entry e;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
-		*inode = inode_open (e.inode_sector);
-	else
-		*inode = NULL;
+	/* Hold DIR_LOCK across inode_open() on a hit too: otherwise a
+	 * dir_remove() and last close could free the sector, and a new
+	 * file reuse it, between the lookup and the open. */
+	parent = inode_get_inumber (dir->inode);
+	rw_read_acquire (&dir_lock);
+	switch (dcache_lookup (parent, name, &e.inode_sector)) {
+		case DCACHE_HIT:
+			*inode = inode_open (e.inode_sector);
+			break;
+		case DCACHE_NEGATIVE:
+			*inode = NULL;
+			break;
+		default:
+			if (lookup (dir, name, &e, NULL, NULL)) {
+				dcache_put (parent, name, false, e.inode_sector);
+				*inode = inode_open (e.inode_sector);
+			} else {
+				dcache_put (parent, name, true, 0);
+				*inode = NULL;
+			}
+	}
+	rw_read_release (&dir_lock);
 
 	return *inode != NULL;
 }
@@ -125,8 +533,8 @@ dir_lookup (const struct dir *dir, const char *name,
  * error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+	struct dir_header h;
 	struct dir_entry e;
-	off_t ofs;
 	bool success = false;
 
 	ASSERT (dir != NULL);
@@ -136,29 +544,39 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
-	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
-		goto done;
-
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
+	/* Check that NAME is not in use.  A cached negative entry
+	 * answers that without reading the directory. */
+	rw_write_acquire (&dir_lock);
+	disk_sector_t parent = inode_get_inumber (dir->inode);
+	switch (dcache_lookup (parent, name, &e.inode_sector)) {
+		case DCACHE_HIT:
+			goto done;
+		case DCACHE_NEGATIVE:
 			break;
+		default:
+			if (lookup (dir, name, NULL, NULL, NULL))
+				goto done;
+	}
+
+	/* Keep the table at most three quarters full so that probe
+	 * chains stay short. */
+	if (!read_header (dir, &h))
+		goto done;
+	if ((h.entry_cnt + 1) * 4 > h.bucket_cnt * BUCKET_ENTRIES * 3
+			&& !grow (dir, &h))
+		goto done;
 
 	/* Write slot. */
+	memset (&e, 0, sizeof e);
 	e.in_use = true;
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
-	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	success = insert (dir, &h, &e) && write_header (dir, &h);
+	if (success)
+		dcache_put (parent, name, false, inode_sector);
 
 done:
+	rw_write_release (&dir_lock);
 	return success;
 }
 
@@ -167,16 +585,19 @@ done:
  * which occurs only if there is no file with the given NAME. */
 bool
 dir_remove (struct dir *dir, const char *name) {
+	struct dir_header h;
+	struct dir_bucket b;
 	struct dir_entry e;
 	struct inode *inode = NULL;
 	bool success = false;
-	off_t ofs;
+	size_t idx, slot;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
-	if (!lookup (dir, name, &e, &ofs))
+	rw_write_acquire (&dir_lock);
+	if (!lookup (dir, name, &e, &idx, &slot))
 		goto done;
 
 	/* Open inode. */
@@ -184,16 +605,23 @@ dir_remove (struct dir *dir, const char *name) {
 	if (inode == NULL)
 		goto done;
 
-	/* Erase directory entry. */
-	e.in_use = false;
-	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+	/* Erase directory entry.  The overflow marks it may have set
+	 * stay, so later entries in the same chain remain reachable. */
+	if (!read_header (dir, &h) || !read_bucket (dir, &h, idx, &b))
+		goto done;
+	b.entries[slot].in_use = false;
+	b.used--;
+	h.entry_cnt--;
+	if (!write_bucket (dir, &h, idx, &b) || !write_header (dir, &h))
 		goto done;
 
 	/* Remove inode. */
 	inode_remove (inode);
+	dcache_put (inode_get_inumber (dir->inode), name, true, 0);
 	success = true;
 
 done:
+	rw_write_release (&dir_lock);
 	inode_close (inode);
 	return success;
 }
@@ -203,10 +631,17 @@ done:
  * contains no more entries. */
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
+	struct dir_header h;
 	struct dir_entry e;
 
-	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
-		dir->pos += sizeof e;
+	if (!read_header (dir, &h))
+		return false;
+	while (dir->pos < (off_t) (h.bucket_cnt * BUCKET_ENTRIES)) {
+		off_t ofs = bucket_ofs (&h, dir->pos / BUCKET_ENTRIES)
+			+ dir->pos % BUCKET_ENTRIES * sizeof e;
+		if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+			break;
+		dir->pos++;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
 			return true;
@@ -1,4 +1,5 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
@@ -20,12 +21,17 @@ struct fat_boot {
 struct fat_fs {
 	struct fat_boot bs;
 	unsigned int *fat;
-	unsigned int fat_length;
-	disk_sector_t data_start;
-	cluster_t last_clst;
-	struct lock write_lock;
+	unsigned int fat_length;    /* Clusters 1 .. fat_length - 1 exist. */
+	disk_sector_t data_start;   /* Sector of cluster 1. */
+	cluster_t last_clst;        /* Free cluster search starts here. */
+	struct lock write_lock;     /* Serializes FAT updates. */
+	struct bitmap *loaded;      /* FAT sectors read into FAT. */
+	struct bitmap *dirty;       /* FAT sectors changed since last written. */
 };
 
+/* FAT entries per FAT sector. */
+#define FAT_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
@@ -51,33 +57,97 @@ fat_init (void) {
 	fat_fs_init ();
 }
 
-void
-fat_open (void) {
+/* Allocates an empty in-memory FAT with nothing loaded or
+ * dirty, replacing any previous one. */
+static void
+fat_alloc_table (void) {
+	free (fat_fs->fat);
+	if (fat_fs->loaded != NULL)
+		bitmap_destroy (fat_fs->loaded);
+	if (fat_fs->dirty != NULL)
+		bitmap_destroy (fat_fs->dirty);
+
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
-	if (fat_fs->fat == NULL)
+	fat_fs->loaded = bitmap_create (fat_fs->bs.fat_sectors);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->fat == NULL || fat_fs->loaded == NULL || fat_fs->dirty == NULL)
 		PANIC ("FAT load failed");
+}
+
+/* Reads FAT sector SEC into the table unless it is already
+ * there.  Must be called with write_lock held. */
+static void
+fat_load (size_t sec) {
+	if (bitmap_test (fat_fs->loaded, sec))
+		return;
+
+	size_t first = sec * FAT_PER_SECTOR;
+	size_t cnt = fat_fs->fat_length - first < FAT_PER_SECTOR
+		? fat_fs->fat_length - first : FAT_PER_SECTOR;
+	if (cnt == FAT_PER_SECTOR) {
+		disk_read (filesys_disk, fat_fs->bs.fat_start + sec, &fat_fs->fat[first]);
+	} else {
+		uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
+		if (bounce == NULL)
+			PANIC ("FAT load failed");
+		disk_read (filesys_disk, fat_fs->bs.fat_start + sec, bounce);
+		memcpy (&fat_fs->fat[first], bounce, cnt * sizeof (cluster_t));
+		free (bounce);
+	}
+	bitmap_mark (fat_fs->loaded, sec);
+}
+
+/* Returns the FAT entry of CLST, loading its sector first.
+ * Must be called with write_lock held. */
+static cluster_t
+fat_entry (cluster_t clst) {
+	fat_load (clst / FAT_PER_SECTOR);
+	return fat_fs->fat[clst];
+}
+
+/* Sets the FAT entry of CLST to VAL and marks its sector dirty.
+ * Must be called with write_lock held. */
+static void
+fat_set (cluster_t clst, cluster_t val) {
+	fat_load (clst / FAT_PER_SECTOR);
+	fat_fs->fat[clst] = val;
+	bitmap_mark (fat_fs->dirty, clst / FAT_PER_SECTOR);
+}
 
-	// Load FAT directly from the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i,
-			           buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
+/* FAT sectors are read on first access instead of all at mount,
+ * so mounting costs the same whatever the disk size. */
+void
+fat_open (void) {
+	fat_alloc_table ();
+}
+
+/* Writes every FAT sector changed since it was last written. */
+void
+fat_flush (void) {
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return;
+
+	lock_acquire (&fat_fs->write_lock);
+	for (size_t sec = bitmap_scan (fat_fs->dirty, 0, 1, true);
+			sec != BITMAP_ERROR;
+			sec = bitmap_scan (fat_fs->dirty, sec + 1, 1, true)) {
+		size_t first = sec * FAT_PER_SECTOR;
+		size_t cnt = fat_fs->fat_length - first < FAT_PER_SECTOR
+			? fat_fs->fat_length - first : FAT_PER_SECTOR;
+		if (cnt == FAT_PER_SECTOR) {
+			disk_write (filesys_disk, fat_fs->bs.fat_start + sec,
+					&fat_fs->fat[first]);
 		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
+			uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
 			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
+				PANIC ("FAT flush failed");
+			memcpy (bounce, &fat_fs->fat[first], cnt * sizeof (cluster_t));
+			disk_write (filesys_disk, fat_fs->bs.fat_start + sec, bounce);
 			free (bounce);
 		}
+		bitmap_reset (fat_fs->dirty, sec);
 	}
+	lock_release (&fat_fs->write_lock);
 }
 
 void
@@ -90,27 +160,8 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
-	}
+	// Write back only the FAT sectors that changed
+	fat_flush ();
 }
 
 void
@@ -119,10 +170,10 @@ fat_create (void) {
 	fat_boot_create ();
 	fat_fs_init ();
 
-	// Create FAT table
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
-	if (fat_fs->fat == NULL)
-		PANIC ("FAT creation failed");
+	// Create FAT table; all of it is new, so all of it is written
+	fat_alloc_table ();
+	bitmap_set_all (fat_fs->loaded, true);
+	bitmap_set_all (fat_fs->dirty, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -152,42 +203,162 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors - fat_fs->data_start)
+		/ SECTORS_PER_CLUSTER;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER + 1;
+	lock_init (&fat_fs->write_lock);
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Returns a free cluster, or 0 if there is none.  The search
+ * starts at the last_clst hint rather than at cluster 1, so
+ * allocation does not rescan the used front of the table, and
+ * wraps around once.  Must be called with write_lock held. */
+static cluster_t
+fat_find_free (void) {
+	cluster_t clst = fat_fs->last_clst;
+
+	for (unsigned n = 1; n < fat_fs->fat_length; n++) {
+		if (clst >= fat_fs->fat_length)
+			clst = 1;
+		if (fat_entry (clst) == 0) {
+			fat_fs->last_clst = clst + 1;
+			return clst;
+		}
+		clst++;
+	}
+	return 0;
+}
+
+/* Returns the first cluster of a run of CNT free clusters,
+ * searching from the last_clst hint, or 0 if there is no such
+ * run.  Must be called with write_lock held. */
+static cluster_t
+fat_find_run (size_t cnt) {
+	cluster_t clst = fat_fs->last_clst;
+	cluster_t start = 0;
+	size_t run = 0;
+
+	for (unsigned n = 1; n < fat_fs->fat_length; n++, clst++) {
+		if (clst >= fat_fs->fat_length) {
+			/* A run does not wrap around the end of the table. */
+			clst = 1;
+			run = 0;
+		}
+		if (fat_entry (clst) != 0) {
+			run = 0;
+			continue;
+		}
+		if (run++ == 0)
+			start = clst;
+		if (run == cnt)
+			return start;
+	}
+	return 0;
+}
+
+/* Appends up to CNT clusters to the chain ending at CLST, or
+ * starts a new chain if CLST is 0, and stores the first new
+ * cluster in *FIRST.  The new clusters are consecutive on disk:
+ * the cluster right after CLST when it is free, else the first
+ * free run of CNT clusters from the hint, else any free cluster.
+ * Returns the number of clusters added, 0 if the disk is full. */
+size_t
+fat_create_run (cluster_t clst, size_t cnt, cluster_t *first) {
+	cluster_t start = 0;
+	size_t got = 0;
+
+	ASSERT (cnt > 0);
+
+	lock_acquire (&fat_fs->write_lock);
+	if (clst != 0 && clst + 1 < fat_fs->fat_length
+			&& fat_entry (clst + 1) == 0)
+		start = clst + 1;
+	if (start == 0 && cnt > 1)
+		start = fat_find_run (cnt);
+	if (start == 0)
+		start = fat_find_free ();
+
+	if (start != 0) {
+		cluster_t prev = clst;
+		while (got < cnt && start + got < fat_fs->fat_length
+				&& fat_entry (start + got) == 0) {
+			fat_set (start + got, EOChain);
+			if (prev != 0)
+				fat_set (prev, start + got);
+			prev = start + got++;
+		}
+		if (start + got > fat_fs->last_clst)
+			fat_fs->last_clst = start + got;
+		*first = start;
+	}
+	lock_release (&fat_fs->write_lock);
+	return got;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t nclst;
+
+	return fat_create_run (clst, 1, &nclst) == 1 ? nclst : 0;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_entry (clst);
+		fat_set (clst, 0);
+		/* Keep the hint at or below the lowest free cluster. */
+		if (clst < fat_fs->last_clst)
+			fat_fs->last_clst = clst;
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	lock_acquire (&fat_fs->write_lock);
+	fat_set (clst, val);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	if (!bitmap_test (fat_fs->loaded, clst / FAT_PER_SECTOR)) {
+		lock_acquire (&fat_fs->write_lock);
+		fat_load (clst / FAT_PER_SECTOR);
+		lock_release (&fat_fs->write_lock);
+	}
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Converts a sector number in the data region to its cluster #. */
+cluster_t
+sector_to_cluster (disk_sector_t sector) {
+	ASSERT (sector >= fat_fs->data_start);
+	return (sector - fat_fs->data_start) / SECTORS_PER_CLUSTER + 1;
 }
@@ -10,6 +10,7 @@ struct file
 	off_t pos;			 /* Current position. */
 	bool deny_write;	 /* Has file_deny_write() been called? */
 	int ref_cnt;
+	struct inode_ra ra;	 /* Sequential read-ahead state. */
 };
 
 void file_ref(struct file *f)
@@ -98,6 +99,7 @@ file_get_inode(struct file *file)
 off_t file_read(struct file *file, void *buffer, off_t size)
 {
 	off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
+	inode_readahead(file->inode, &file->ra, file->pos, bytes_read);
 	file->pos += bytes_read;
 	return bytes_read;
 }
@@ -109,7 +111,9 @@ off_t file_read(struct file *file, void *buffer, off_t size)
  * The file's current position is unaffected. */
 off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs)
 {
-	return inode_read_at(file->inode, buffer, size, file_ofs);
+	off_t bytes_read = inode_read_at(file->inode, buffer, size, file_ofs);
+	inode_readahead(file->inode, &file->ra, file_ofs, bytes_read);
+	return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into FILE,
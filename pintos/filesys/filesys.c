@@ -7,6 +7,9 @@
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "devices/disk.h"
+#ifdef EFILESYS
+#include "filesys/page_cache.h"
+#endif
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
@@ -22,8 +25,10 @@ filesys_init (bool format) {
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init ();
+	dir_init ();
 
 #ifdef EFILESYS
+	page_cache_init ();
 	fat_init ();
 
 	if (format)
@@ -47,6 +52,7 @@ void
 filesys_done (void) {
 	/* Original FS */
 #ifdef EFILESYS
+	page_cache_flush ();
 	fat_close ();
 #else
 	free_map_close ();
@@ -61,12 +67,24 @@ bool
 filesys_create (const char *name, off_t initial_size) {
 	disk_sector_t inode_sector = 0;
 	struct dir *dir = dir_open_root ();
+#ifdef EFILESYS
+	/* The inode gets a cluster of its own. */
+	cluster_t inode_clst = dir != NULL ? fat_create_chain (0) : 0;
+	if (inode_clst != 0)
+		inode_sector = cluster_to_sector (inode_clst);
+	bool success = (inode_clst != 0
+			&& inode_create (inode_sector, initial_size)
+			&& dir_add (dir, name, inode_sector));
+	if (!success && inode_clst != 0)
+		fat_remove_chain (inode_clst, 0);
+#else
 	bool success = (dir != NULL
 			&& free_map_allocate (1, &inode_sector)
 			&& inode_create (inode_sector, initial_size)
 			&& dir_add (dir, name, inode_sector));
 	if (!success && inode_sector != 0)
 		free_map_release (inode_sector, 1);
+#endif
 	dir_close (dir);
 
 	return success;
@@ -110,6 +128,8 @@ do_format (void) {
 #ifdef EFILESYS
 	/* Create FAT and save it to the disk. */
 	fat_create ();
+	if (!dir_create (ROOT_DIR_SECTOR, 16))
+		PANIC ("root directory creation failed");
 	fat_close ();
 #else
 	free_map_create ();
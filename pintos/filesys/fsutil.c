@@ -6,6 +6,7 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "devices/disk.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
@@ -26,6 +27,34 @@ fsutil_ls (char **argv UNUSED) {
 	printf ("End of listing.\n");
 }
 
+/* Reports how fragmented each file in the root directory is:
+ * its length and the number of separate runs of sectors its
+ * data occupies.  A file in one run reads sequentially. */
+void
+fsutil_frag (char **argv UNUSED) {
+	struct dir *dir;
+	char name[NAME_MAX + 1];
+	size_t files = 0, frags = 0;
+
+	printf ("Fragmentation of the root directory:\n");
+	dir = dir_open_root ();
+	if (dir == NULL)
+		PANIC ("root dir open failed");
+	while (dir_readdir (dir, name)) {
+		struct file *file = filesys_open (name);
+		if (file == NULL)
+			continue;
+		size_t n = inode_fragments (file_get_inode (file));
+		printf ("%-14s %8"PROTd" bytes %4zu fragments\n", name,
+				file_length (file), n);
+		files++;
+		frags += n;
+		file_close (file);
+	}
+	dir_close (dir);
+	printf ("%zu files, %zu fragments.\n", files, frags);
+}
+
 /* Prints the contents of file ARGV[1] to the system console as
  * hex and ASCII. */
 void
@@ -1,23 +1,71 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/directory.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#include "filesys/page_cache.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+#ifdef EFILESYS
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * A file's data is the FAT chain starting at START. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
+	cluster_t start;                    /* First data cluster, 0 if none. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
 	uint32_t unused[125];               /* Not used. */
 };
+#else
+/* A run of CNT consecutive data sectors starting at START. */
+struct extent {
+	disk_sector_t start;                /* First sector of the run. */
+	uint32_t cnt;                       /* Number of sectors. */
+};
+
+/* Extents held in the inode itself and in each extent block. */
+#define INODE_EXTENTS 62
+#define BLOCK_EXTENTS 63
+
+/* On-disk inode.
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * A file's data is the concatenation of its extents in order.
+ * The first INODE_EXTENTS live here, the rest in a chain of
+ * extent blocks starting at NEXT. */
+struct inode_disk {
+	off_t length;                       /* File size in bytes. */
+	unsigned magic;                     /* Magic number. */
+	uint32_t extent_cnt;                /* Number of extents in total. */
+	disk_sector_t next;                 /* First extent block, 0 if none. */
+	struct extent extents[INODE_EXTENTS];
+};
+
+/* Overflow extents of an inode.
+ * Must be exactly DISK_SECTOR_SIZE bytes long. */
+struct extent_block {
+	disk_sector_t next;                 /* Next extent block, 0 if none. */
+	uint32_t unused;                    /* Not used. */
+	struct extent extents[BLOCK_EXTENTS];
+};
+
+/* An extent as the in-memory extent cache holds it: the file
+ * sector it starts at is precomputed so lookups can bisect. */
+struct extent_map {
+	uint32_t lsec;                      /* First file sector of the run. */
+	disk_sector_t start;                /* First disk sector of the run. */
+	uint32_t cnt;                       /* Number of sectors. */
+};
+#endif
 
 /* Returns the number of sectors to allocate for an inode SIZE
  * bytes long. */
@@ -28,14 +76,214 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem elem;              /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
+	bool closing;                       /* Last close writing back. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock lock;                 /* Guards DATA and the index below. */
 	struct inode_disk data;             /* Inode content. */
+#ifdef EFILESYS
+	cluster_t *clusters;                /* Cluster index: the chain in order. */
+	size_t clst_cnt;                    /* Number of entries in CLUSTERS. */
+	size_t clst_cap;                    /* Allocated entries in CLUSTERS. */
+#else
+	struct extent_map *map;             /* Every extent, sorted by lsec. */
+	size_t map_cnt;                     /* Number of entries in MAP. */
+	size_t map_cap;                     /* Allocated entries in MAP. */
+	disk_sector_t *blocks;              /* Extent block sectors, in order. */
+	size_t block_cnt;                   /* Number of entries in BLOCKS. */
+#endif
 };
 
+/* Reads sector SECTOR of the file system disk into BUFFER. */
+static void
+sector_read (disk_sector_t sector, void *buffer) {
+#ifdef EFILESYS
+	page_cache_read (sector, buffer, 0, DISK_SECTOR_SIZE);
+#else
+	disk_read (filesys_disk, sector, buffer);
+#endif
+}
+
+/* Writes BUFFER to sector SECTOR of the file system disk. */
+static void
+sector_write (disk_sector_t sector, const void *buffer) {
+#ifdef EFILESYS
+	page_cache_write (sector, buffer, 0, DISK_SECTOR_SIZE);
+#else
+	disk_write (filesys_disk, sector, buffer);
+#endif
+}
+
+#ifdef EFILESYS
+/* Bytes of file data per cluster. */
+#define CLUSTER_BYTES (SECTORS_PER_CLUSTER * DISK_SECTOR_SIZE)
+
+/* Clusters put on the chain at once when an existing file grows,
+ * so that appends keep landing next to each other.  Those past
+ * the end of file are given back at the last close. */
+#define PREALLOC_CLUSTERS 8
+
+/* Returns the disk sector that contains byte offset POS within
+ * INODE.
+ * Returns -1 if INODE does not contain data for a byte at offset
+ * POS.  The cluster index makes this a single array lookup. */
+static disk_sector_t
+byte_to_sector (const struct inode *inode, off_t pos) {
+	ASSERT (inode != NULL);
+	if (pos >= inode->data.length)
+		return -1;
+	return cluster_to_sector (inode->clusters[pos / CLUSTER_BYTES])
+		+ pos % CLUSTER_BYTES / DISK_SECTOR_SIZE;
+}
+
+/* Appends CLST to INODE's cluster index.  Returns false if
+ * memory runs out. */
+static bool
+index_append (struct inode *inode, cluster_t clst) {
+	if (inode->clst_cnt == inode->clst_cap) {
+		size_t cap = inode->clst_cap > 0 ? inode->clst_cap * 2 : 8;
+		cluster_t *clusters = realloc (inode->clusters, cap * sizeof *clusters);
+		if (clusters == NULL)
+			return false;
+		inode->clusters = clusters;
+		inode->clst_cap = cap;
+	}
+	inode->clusters[inode->clst_cnt++] = clst;
+	return true;
+}
+
+/* Walks INODE's FAT chain once and records every cluster in the
+ * cluster index, so that no later access walks the chain.
+ * Returns false if memory runs out. */
+static bool
+inode_load_index (struct inode *inode) {
+	inode->clusters = NULL;
+	inode->clst_cnt = inode->clst_cap = 0;
+	for (cluster_t clst = inode->data.start; clst != 0 && clst != EOChain;
+			clst = fat_get (clst))
+		if (!index_append (inode, clst)) {
+			free (inode->clusters);
+			return false;
+		}
+	return true;
+}
+
+/* Frees INODE's cluster index. */
+static void
+inode_free_index (struct inode *inode) {
+	free (inode->clusters);
+}
+
+/* Extends INODE's chain until it covers LENGTH bytes, zeroes
+ * the clusters that come into the file, sets its length to
+ * LENGTH and writes the inode back.  A file that already has
+ * data grows by at least PREALLOC_CLUSTERS at a time.  Returns
+ * false, with the length unchanged, if the disk or memory runs
+ * out; clusters already added stay on the chain for the next
+ * attempt. */
+static bool
+inode_grow (struct inode *inode, off_t length) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t have = DIV_ROUND_UP (inode->data.length, CLUSTER_BYTES);
+	size_t want = DIV_ROUND_UP (length, CLUSTER_BYTES);
+	bool success = true;
+
+	while (inode->clst_cnt < want) {
+		size_t need = want - inode->clst_cnt;
+		cluster_t tail = inode->clst_cnt > 0
+			? inode->clusters[inode->clst_cnt - 1] : 0;
+		cluster_t first;
+		size_t got;
+
+		if (tail != 0 && need < PREALLOC_CLUSTERS)
+			need = PREALLOC_CLUSTERS;
+		got = fat_create_run (tail, need, &first);
+		if (got == 0) {
+			success = false;
+			break;
+		}
+		if (tail == 0)
+			inode->data.start = first;
+		for (size_t i = 0; i < got; i++)
+			if (!index_append (inode, first + i)) {
+				/* Cut the chain back to what the index holds. */
+				if (inode->clst_cnt == 0)
+					inode->data.start = 0;
+				fat_remove_chain (first + i, inode->clst_cnt > 0
+						? inode->clusters[inode->clst_cnt - 1] : 0);
+				success = false;
+				break;
+			}
+		if (!success)
+			break;
+	}
+
+	if (success) {
+		/* Preallocated clusters are zeroed only once they are used. */
+		for (size_t i = have; i < want; i++)
+			for (size_t j = 0; j < SECTORS_PER_CLUSTER; j++)
+				sector_write (cluster_to_sector (inode->clusters[i]) + j, zeros);
+		inode->data.length = length;
+	}
+	sector_write (inode->sector, &inode->data);
+	return success;
+}
+
+/* Gives back the clusters preallocated past INODE's end of
+ * file. */
+static void
+inode_trim (struct inode *inode) {
+	size_t keep = DIV_ROUND_UP (inode->data.length, CLUSTER_BYTES);
+
+	if (keep >= inode->clst_cnt)
+		return;
+	fat_remove_chain (inode->clusters[keep],
+			keep > 0 ? inode->clusters[keep - 1] : 0);
+	inode->clst_cnt = keep;
+	if (keep == 0) {
+		inode->data.start = 0;
+		sector_write (inode->sector, &inode->data);
+	}
+}
+
+/* Returns the number of runs of consecutive clusters INODE's data
+ * is split into. */
+size_t
+inode_fragments (const struct inode *inode) {
+	size_t frags = 0;
+
+	for (size_t i = 0; i < inode->clst_cnt; i++)
+		if (i == 0 || inode->clusters[i] != inode->clusters[i - 1] + 1)
+			frags++;
+	return frags;
+}
+
+/* Returns INODE's data clusters to the FAT. */
+static void
+inode_release (struct inode *inode) {
+	if (inode->data.start != 0)
+		fat_remove_chain (inode->data.start, 0);
+}
+
+/* Writes back INODE's sector and its data from the buffer cache,
+ * one range per run of consecutive clusters. */
+static void
+inode_flush (struct inode *inode) {
+	page_cache_flush_range (inode->sector, 1);
+	for (size_t i = 0; i < inode->clst_cnt; ) {
+		size_t run = 1;
+		while (i + run < inode->clst_cnt
+				&& inode->clusters[i + run] == inode->clusters[i] + run)
+			run++;
+		page_cache_flush_range (cluster_to_sector (inode->clusters[i]),
+				run * SECTORS_PER_CLUSTER);
+		i += run;
+	}
+}
+#else
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
@@ -43,20 +291,255 @@ struct inode {
 static disk_sector_t
 byte_to_sector (const struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
-	else
+	if (pos >= inode->data.length)
 		return -1;
+
+	/* Bisect for the last extent starting at or before POS. */
+	uint32_t lsec = pos / DISK_SECTOR_SIZE;
+	size_t lo = 0, hi = inode->map_cnt;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (inode->map[mid].lsec <= lsec)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return inode->map[lo].start + (lsec - inode->map[lo].lsec);
+}
+
+/* Returns the number of data sectors allocated to INODE, which
+ * may exceed what its length needs after a failed growth. */
+static size_t
+inode_allocated (const struct inode *inode) {
+	const struct extent_map *last;
+
+	if (inode->map_cnt == 0)
+		return 0;
+	last = &inode->map[inode->map_cnt - 1];
+	return last->lsec + last->cnt;
+}
+
+/* Reads INODE's extents from its on-disk inode and extent blocks
+ * into the extent cache.  Returns false if memory runs out. */
+static bool
+inode_load_index (struct inode *inode) {
+	size_t cnt = inode->data.extent_cnt;
+	struct extent_block *block = NULL;
+	disk_sector_t next = inode->data.next;
+	uint32_t lsec = 0;
+
+	inode->map_cnt = inode->map_cap = cnt;
+	inode->map = cnt > 0 ? malloc (cnt * sizeof *inode->map) : NULL;
+	inode->block_cnt = 0;
+	inode->blocks = NULL;
+	if (cnt > INODE_EXTENTS) {
+		size_t blocks = DIV_ROUND_UP (cnt - INODE_EXTENTS, BLOCK_EXTENTS);
+		inode->blocks = malloc (blocks * sizeof *inode->blocks);
+		block = malloc (sizeof *block);
+		if (inode->blocks == NULL || block == NULL)
+			goto fail;
+	}
+	if (cnt > 0 && inode->map == NULL)
+		goto fail;
+
+	for (size_t i = 0; i < cnt; i++) {
+		const struct extent *e;
+
+		if (i < INODE_EXTENTS)
+			e = &inode->data.extents[i];
+		else {
+			size_t j = (i - INODE_EXTENTS) % BLOCK_EXTENTS;
+			if (j == 0) {
+				inode->blocks[inode->block_cnt++] = next;
+				sector_read (next, block);
+				next = block->next;
+			}
+			e = &block->extents[j];
+		}
+		inode->map[i].lsec = lsec;
+		inode->map[i].start = e->start;
+		inode->map[i].cnt = e->cnt;
+		lsec += e->cnt;
+	}
+	free (block);
+	return true;
+
+fail:
+	free (block);
+	free (inode->blocks);
+	free (inode->map);
+	return false;
+}
+
+/* Returns the number of runs of consecutive sectors INODE's data
+ * is split into. */
+size_t
+inode_fragments (const struct inode *inode) {
+	return inode->map_cnt;
+}
+
+/* Frees INODE's extent cache. */
+static void
+inode_free_index (struct inode *inode) {
+	free (inode->map);
+	free (inode->blocks);
+}
+
+/* Writes INODE's on-disk inode, and every extent block holding
+ * extent FROM or a later one, back to disk.  Allocates extent
+ * blocks as the extent count needs them.  Returns false if that
+ * allocation fails. */
+static bool
+inode_save (struct inode *inode, size_t from) {
+	size_t cnt = inode->map_cnt;
+	size_t blocks = cnt > INODE_EXTENTS
+		? DIV_ROUND_UP (cnt - INODE_EXTENTS, BLOCK_EXTENTS) : 0;
+	bool success = true;
+
+	while (inode->block_cnt < blocks) {
+		disk_sector_t *b = realloc (inode->blocks,
+				(inode->block_cnt + 1) * sizeof *b);
+		if (b == NULL)
+			return false;
+		inode->blocks = b;
+		if (!free_map_allocate (1, &b[inode->block_cnt]))
+			return false;
+		inode->block_cnt++;
+	}
+
+	if (blocks > 0) {
+		struct extent_block *block = calloc (1, sizeof *block);
+		size_t first = from > INODE_EXTENTS
+			? (from - INODE_EXTENTS) / BLOCK_EXTENTS : 0;
+
+		if (block == NULL)
+			success = false;
+		for (size_t b = first; success && b < blocks; b++) {
+			size_t base = INODE_EXTENTS + b * BLOCK_EXTENTS;
+			size_t n = cnt - base < BLOCK_EXTENTS ? cnt - base : BLOCK_EXTENTS;
+
+			block->next = b + 1 < blocks ? inode->blocks[b + 1] : 0;
+			for (size_t j = 0; j < n; j++) {
+				block->extents[j].start = inode->map[base + j].start;
+				block->extents[j].cnt = inode->map[base + j].cnt;
+			}
+			sector_write (inode->blocks[b], block);
+		}
+		free (block);
+	}
+
+	for (size_t i = 0; i < cnt && i < INODE_EXTENTS; i++) {
+		inode->data.extents[i].start = inode->map[i].start;
+		inode->data.extents[i].cnt = inode->map[i].cnt;
+	}
+	inode->data.extent_cnt = cnt;
+	inode->data.next = blocks > 0 ? inode->blocks[0] : 0;
+	sector_write (inode->sector, &inode->data);
+	return success;
+}
+
+/* Allocates data sectors for INODE until it covers LENGTH bytes,
+ * zeroes them and sets its length to LENGTH.  New sectors extend
+ * the last extent in place when the sectors after it are free;
+ * otherwise they start a new extent, as long as the free map can
+ * give and falling back to shorter runs.  Returns false, with the
+ * length unchanged, if the disk or memory runs out; any sectors
+ * already added stay allocated for the next attempt. */
+static bool
+inode_grow (struct inode *inode, off_t length) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t have = inode_allocated (inode);
+	size_t want = bytes_to_sectors (length);
+	size_t from = inode->map_cnt > 0 ? inode->map_cnt - 1 : 0;
+	bool success = true;
+
+	while (have < want) {
+		size_t need = want - have;
+		disk_sector_t start = 0;
+		size_t got = 0;
+
+		if (inode->map_cnt > 0) {
+			struct extent_map *last = &inode->map[inode->map_cnt - 1];
+			start = last->start + last->cnt;
+			got = free_map_extend (start, need);
+			last->cnt += got;
+		}
+		if (got == 0) {
+			for (got = need; got > 0; got /= 2)
+				if (free_map_allocate (got, &start))
+					break;
+			if (got == 0) {
+				success = false;
+				break;
+			}
+			if (inode->map_cnt == inode->map_cap) {
+				size_t cap = inode->map_cap > 0 ? inode->map_cap * 2 : 4;
+				struct extent_map *map = realloc (inode->map, cap * sizeof *map);
+				if (map == NULL) {
+					free_map_release (start, got);
+					success = false;
+					break;
+				}
+				inode->map = map;
+				inode->map_cap = cap;
+			}
+			inode->map[inode->map_cnt].lsec = have;
+			inode->map[inode->map_cnt].start = start;
+			inode->map[inode->map_cnt].cnt = got;
+			inode->map_cnt++;
+		}
+
+		for (size_t i = 0; i < got; i++)
+			sector_write (start + i, zeros);
+		have += got;
+	}
+
+	if (success)
+		inode->data.length = length;
+	return inode_save (inode, from) && success;
+}
+
+/* Returns every sector INODE owns, data and extent blocks, to
+ * the free map. */
+static void
+inode_release (struct inode *inode) {
+	for (size_t i = 0; i < inode->map_cnt; i++)
+		free_map_release (inode->map[i].start, inode->map[i].cnt);
+	for (size_t i = 0; i < inode->block_cnt; i++)
+		free_map_release (inode->blocks[i], 1);
 }
+#endif
 
-/* List of open inodes, so that opening a single inode twice
+/* Open inodes by sector, so that opening a single inode twice
  * returns the same `struct inode'. */
-static struct list open_inodes;
+static struct hash open_inodes;
+
+/* Protects open_inodes and every inode's open_cnt and closing, so
+ * that processes may open and close inodes concurrently. */
+static struct lock open_inodes_lock;
+
+/* Signalled, with open_inodes_lock, when a closing inode leaves
+ * open_inodes. */
+static struct condition inode_closed;
+
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode, elem)->sector);
+}
+
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode, elem)->sector
+		< hash_entry (b, struct inode, elem)->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&open_inodes, inode_hash, inode_less, NULL);
+	lock_init (&open_inodes_lock);
+	cond_init (&inode_closed);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -66,32 +549,27 @@ inode_init (void) {
  * Returns false if memory or disk allocation fails. */
 bool
 inode_create (disk_sector_t sector, off_t length) {
-	struct inode_disk *disk_inode = NULL;
+	struct inode *inode = NULL;
 	bool success = false;
 
 	ASSERT (length >= 0);
 
 	/* If this assertion fails, the inode structure is not exactly
 	 * one sector in size, and you should fix that. */
-	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
-
-	disk_inode = calloc (1, sizeof *disk_inode);
-	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
-		disk_inode->length = length;
-		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
-		free (disk_inode);
+	ASSERT (sizeof inode->data == DISK_SECTOR_SIZE);
+#ifndef EFILESYS
+	ASSERT (sizeof (struct extent_block) == DISK_SECTOR_SIZE);
+#endif
+
+	inode = calloc (1, sizeof *inode);
+	if (inode != NULL) {
+		inode->sector = sector;
+		inode->data.magic = INODE_MAGIC;
+		success = inode_grow (inode, length);
+		if (!success)
+			inode_release (inode);
+		inode_free_index (inode);
+		free (inode);
 	}
 	return success;
 }
@@ -101,39 +579,59 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	struct hash_elem *e;
 	struct inode *inode;
-
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
+	struct inode key;
+
+	/* Check whether this inode is already open.  The lock is held
+	 * until a new inode is in the table, so two openers of the
+	 * same sector cannot both read it in.  An inode still being
+	 * written back by its last close is waited out, so that it is
+	 * read back only once the disk is up to date. */
+	lock_acquire (&open_inodes_lock);
+	key.sector = sector;
+	while ((e = hash_find (&open_inodes, &key.elem)) != NULL) {
+		inode = hash_entry (e, struct inode, elem);
+		if (!inode->closing) {
+			inode->open_cnt++;
+			lock_release (&open_inodes_lock);
+			return inode;
 		}
+		cond_wait (&inode_closed, &open_inodes_lock);
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	inode->closing = false;
+	rw_init (&inode->lock);
+	sector_read (inode->sector, &inode->data);
+	if (!inode_load_index (inode)) {
+		free (inode);
+		inode = NULL;
+	} else
+		hash_insert (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -152,20 +650,46 @@ inode_close (struct inode *inode) {
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
-		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
-
-		free (inode); 
+	/* Release resources if this was the last opener.  The inode
+	 * stays in the table, marked closing, until they are gone, so a
+	 * concurrent open of the same sector waits in inode_open() and
+	 * reads the inode only after it is consistent.  The lock is not
+	 * held during the I/O, so other opens and closes go on. */
+	lock_acquire (&open_inodes_lock);
+	if (--inode->open_cnt > 0) {
+		lock_release (&open_inodes_lock);
+		return;
+	}
+	inode->closing = true;
+	lock_release (&open_inodes_lock);
+
+	/* Deallocate blocks if removed. */
+	if (inode->removed) {
+		/* Nothing may stay cached under a directory sector about
+		 * to be reused. */
+		dir_forget (inode->sector);
+#ifdef EFILESYS
+		fat_remove_chain (sector_to_cluster (inode->sector), 0);
+#else
+		free_map_release (inode->sector, 1);
+#endif
+		inode_release (inode);
+	}
+#ifdef EFILESYS
+	else {
+		inode_trim (inode);
+		/* Write-behind ends with the last close. */
+		inode_flush (inode);
 	}
+#endif
+	inode_free_index (inode);
+
+	/* Remove from inode table. */
+	lock_acquire (&open_inodes_lock);
+	hash_delete (&open_inodes, &inode->elem);
+	cond_broadcast (&inode_closed, &open_inodes_lock);
+	lock_release (&open_inodes_lock);
+	free (inode);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -185,6 +709,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	rw_read_acquire (&inode->lock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -200,6 +725,10 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
+#ifdef EFILESYS
+		/* Copy out of the buffer cache; no bounce buffer needed. */
+		page_cache_read (sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
+#else
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Read full sector directly into caller's buffer. */
 			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
@@ -214,22 +743,24 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			disk_read (filesys_disk, sector_idx, bounce);
 			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
 		}
+#endif
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rw_read_release (&inode->lock);
 	free (bounce);
 
 	return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+ * A write past end of file first extends the inode, filling any
+ * gap with zeros.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the disk is full or an error occurs. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
@@ -240,6 +771,14 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	if (inode->deny_write_cnt)
 		return 0;
 
+	rw_write_acquire (&inode->lock);
+	if (size > 0 && offset + size > inode_length (inode)
+			&& !inode_grow (inode, offset + size)) {
+		/* Out of space: the length is unchanged, so write only
+		 * what fits within it. */
+		size = offset < inode_length (inode) ? inode_length (inode) - offset : 0;
+	}
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -255,6 +794,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
+#ifdef EFILESYS
+		/* Copy into the buffer cache, which reads the sector first
+		   only if the chunk leaves part of it untouched. */
+		page_cache_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
+#else
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Write full sector directly to disk. */
 			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
@@ -276,12 +820,14 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
 			disk_write (filesys_disk, sector_idx, bounce); 
 		}
+#endif
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	rw_write_release (&inode->lock);
 	free (bounce);
 
 	return bytes_written;
@@ -306,6 +852,52 @@ inode_allow_write (struct inode *inode) {
 	inode->deny_write_cnt--;
 }
 
+/* Smallest and largest read-ahead windows, in bytes.  The
+ * smallest is one page cache group. */
+#define RA_MIN (PAGE_CACHE_SECTORS * DISK_SECTOR_SIZE)
+#define RA_MAX (8 * RA_MIN)
+
+/* Updates RA after a read of SIZE bytes at OFFSET in INODE and
+ * queues the part of the window past it that is not yet queued.
+ * Sequential reads double the window up to RA_MAX; a seek drops
+ * it, so random access never prefetches.  The prefetch itself
+ * runs in the page cache's readahead daemon. */
+void
+inode_readahead (struct inode *inode UNUSED, struct inode_ra *ra UNUSED,
+		off_t offset UNUSED, off_t size UNUSED) {
+#ifdef EFILESYS
+	if (size <= 0)
+		return;
+
+	if (offset == ra->next)
+		ra->window = ra->window == 0 ? RA_MIN
+			: ra->window * 2 < RA_MAX ? ra->window * 2 : RA_MAX;
+	else
+		ra->window = ra->async_end = 0;
+	ra->next = offset + size;
+	if (ra->window == 0)
+		return;
+
+	off_t start = ra->async_end > ra->next ? ra->async_end : ra->next;
+	off_t end = ra->next + ra->window;
+	if (end > inode_length (inode))
+		end = inode_length (inode);
+
+	/* One request per cache group the range touches. */
+	disk_sector_t last = 0;
+	rw_read_acquire (&inode->lock);
+	for (off_t pos = start; pos < end; pos += DISK_SECTOR_SIZE) {
+		disk_sector_t group = byte_to_sector (inode, pos) / PAGE_CACHE_SECTORS;
+		if (pos == start || group != last)
+			page_cache_prefetch (byte_to_sector (inode, pos));
+		last = group;
+	}
+	rw_read_release (&inode->lock);
+	if (end > ra->async_end)
+		ra->async_end = end;
+#endif
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode) {
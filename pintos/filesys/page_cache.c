@@ -1,6 +1,18 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
 #include "vm/vm.h"
+#include "filesys/page_cache.h"
+#include <debug.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/fat.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#ifdef EFILESYS
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
@@ -15,36 +27,497 @@ static const struct page_operations page_cache_op = {
 
 tid_t page_cache_workerd;
 
+/* Number of pages in the cache (PAGE_CACHE_SECTORS sectors each). */
+#define CACHE_PAGES 32
+
+/* How often the flusher daemon writes dirty sectors back. */
+#define FLUSH_INTERVAL TIMER_FREQ
+
+/* Wakes the flusher every FLUSH_INTERVAL ticks, on a fixed beat
+ * however long each flush takes. */
+static struct ktimer flush_timer;
+static struct semaphore flush_sema;
+
+/* All cache pages, allocated on demand up to CACHE_PAGES.
+ * The clock hand walks this array for eviction. */
+static struct page *cache_pages[CACHE_PAGES];
+static size_t cache_cnt;
+static size_t cache_hand;
+
+/* Maps a sector group base to its cache page. */
+static struct hash cache_map;
+
+/* Protects everything above and the contents of every cache page,
+ * except a page marked io_busy: its data and sector bits belong to
+ * the thread doing its disk I/O until that thread clears io_busy. */
+static struct lock cache_lock;
+
+/* Signalled whenever a page's io_busy fill or write-back finishes. */
+static struct condition io_done;
+
+/* Sectors handed to the readahead daemon, as a ring.  A full
+ * queue drops new requests; readahead is only a hint. */
+#define PREFETCH_QUEUE 32
+static disk_sector_t prefetch_queue[PREFETCH_QUEUE];
+static size_t prefetch_head;
+static size_t prefetch_cnt;
+static struct semaphore prefetch_sema;
+
+static bool cache_inited;
+
+static void cache_writeback (struct page *page);
+static void page_cache_kworkerd (void *aux);
+static void flush_tick (void *aux);
+static void page_cache_kreadaheadd (void *aux);
+
+static uint64_t
+cache_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct page_cache *pc = hash_entry (e, struct page_cache, elem);
+	return hash_int (pc->base);
+}
+
+static bool
+cache_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct page_cache, elem)->base
+		< hash_entry (b, struct page_cache, elem)->base;
+}
+
 /* The initializer of file vm */
+/* Sets up the cache and its flusher daemon.  Both filesys_init()
+ * and vm_init() call this, so only the first call does anything. */
 void
-pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+page_cache_init (void) {
+	if (cache_inited)
+		return;
+	cache_inited = true;
+
+	lock_init (&cache_lock);
+	cond_init (&io_done);
+	sema_init (&prefetch_sema, 0);
+	sema_init (&flush_sema, 0);
+	ktimer_init (&flush_timer, flush_tick, NULL);
+	ktimer_add (&flush_timer, timer_ticks () + FLUSH_INTERVAL);
+	hash_init (&cache_map, cache_hash, cache_less, NULL);
+	cache_cnt = cache_hand = 0;
+	prefetch_head = prefetch_cnt = 0;
+	page_cache_workerd = thread_create ("kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
+	thread_create ("kreadaheadd", PRI_DEFAULT, page_cache_kreadaheadd, NULL);
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
 
+	struct page_cache *pc = &page->page_cache;
+	pc->kva = kva;
+	pc->base = 0;
+	pc->valid = pc->dirty = pc->partial = 0;
+	pc->accessed = false;
+	pc->io_busy = false;
+	pc->pin_cnt = 0;
+	return true;
+}
+
+/* Number of sectors of the group starting at BASE that exist on
+ * the file system disk. */
+static size_t
+group_sectors (disk_sector_t base) {
+	disk_sector_t size = disk_size (filesys_disk);
+	return size - base < PAGE_CACHE_SECTORS ? size - base : PAGE_CACHE_SECTORS;
+}
+
+/* Reads partial sector IDX of PC from disk around the bytes
+ * already written to it, which makes the sector valid. */
+static void
+merge_partial (struct page_cache *pc, size_t idx) {
+	uint8_t *data = (uint8_t *) pc->kva + idx * DISK_SECTOR_SIZE;
+	uint8_t bounce[DISK_SECTOR_SIZE];
+
+	disk_read (filesys_disk, pc->base + idx, bounce);
+	memcpy (bounce + pc->lo[idx], data + pc->lo[idx], pc->hi[idx] - pc->lo[idx]);
+	memcpy (data, bounce, DISK_SECTOR_SIZE);
+	pc->partial &= ~(1u << idx);
+	pc->valid |= 1u << idx;
 }
 
 /* Utilze the Swap in mechanism to implement readhead */
+/* Fills every invalid sector of PAGE's group from disk.  When
+ * nothing is valid yet the whole group comes in with one
+ * command, which reads ahead the sectors that follow the one
+ * being asked for. */
 static bool
 page_cache_readahead (struct page *page, void *kva) {
+	struct page_cache *pc = &page->page_cache;
+	size_t cnt = group_sectors (pc->base);
+	uint8_t all = (1u << cnt) - 1;
+
+	if (pc->valid == 0 && pc->partial == 0) {
+		disk_read_multiple (filesys_disk, pc->base, cnt, kva);
+	} else {
+		for (size_t i = 0; i < cnt; i++)
+			if (pc->partial & (1u << i))
+				merge_partial (pc, i);
+			else if (!(pc->valid & (1u << i)))
+				disk_read (filesys_disk, pc->base + i,
+						(uint8_t *) kva + i * DISK_SECTOR_SIZE);
+	}
+	pc->valid = all;
+	return true;
 }
 
 /* Utilze the Swap out mechanism to implement writeback */
+/* Writes PAGE's dirty sectors back, one command per run of
+ * consecutive dirty sectors.  Partial sectors are completed from
+ * disk first. */
 static bool
 page_cache_writeback (struct page *page) {
+	struct page_cache *pc = &page->page_cache;
+	size_t i = 0;
+
+	for (size_t j = 0; pc->partial != 0; j++)
+		if (pc->partial & (1u << j))
+			merge_partial (pc, j);
+
+	while (pc->dirty != 0) {
+		while (!(pc->dirty & (1u << i)))
+			i++;
+		size_t run = 0;
+		while (i + run < PAGE_CACHE_SECTORS && (pc->dirty & (1u << (i + run))))
+			run++;
+		disk_write_multiple (filesys_disk, pc->base + i, run,
+				(uint8_t *) pc->kva + i * DISK_SECTOR_SIZE);
+		pc->dirty &= ~(((1u << run) - 1) << i);
+		i += run;
+	}
+	return true;
 }
 
 /* Destory the page_cache. */
 static void
 page_cache_destroy (struct page *page) {
+	page_cache_writeback (page);
+	palloc_free_page (page->page_cache.kva);
+}
+
+/* Picks a page to reuse with the clock algorithm and drops it
+ * from the lookup table.  If the page the clock settles on is
+ * dirty, writes it back instead, with cache_lock released, and
+ * returns NULL with *RETRY set: the cache may have changed in the
+ * meantime, so the caller must look its sector up again.  Returns
+ * NULL with *RETRY clear if every page is pinned.  Must be called
+ * with cache_lock held. */
+static struct page *
+cache_evict (bool *retry) {
+	*retry = false;
+	for (size_t i = 0; i < 2 * cache_cnt; i++) {
+		struct page *page = cache_pages[cache_hand];
+		struct page_cache *pc = &page->page_cache;
+		cache_hand = (cache_hand + 1) % cache_cnt;
+
+		if (pc->pin_cnt > 0 || pc->io_busy)
+			continue;
+		if (pc->accessed) {
+			pc->accessed = false;
+			continue;
+		}
+		if (pc->dirty != 0) {
+			cache_writeback (page);
+			*retry = true;
+			return NULL;
+		}
+		hash_delete (&cache_map, &pc->elem);
+		pc->valid = 0;
+		return page;
+	}
+	return NULL;
+}
+
+/* Returns the pinned cache page holding SECTOR, bringing in an
+ * empty one for its group if needed.  Must be called with
+ * cache_lock held. */
+static struct page *
+cache_get (disk_sector_t sector) {
+	struct page_cache key;
+	struct hash_elem *e;
+	struct page *page;
+
+	key.base = sector - sector % PAGE_CACHE_SECTORS;
+	for (;;) {
+		bool retry;
+
+		e = hash_find (&cache_map, &key.elem);
+		if (e != NULL) {
+			page = hash_entry (e, struct page, page_cache.elem);
+			break;
+		}
+		page = NULL;
+		if (cache_cnt < CACHE_PAGES) {
+			void *kva = palloc_get_page (0);
+			if (kva != NULL) {
+				page = malloc (sizeof *page);
+				if (page == NULL)
+					palloc_free_page (kva);
+				else {
+					page_cache_initializer (page, VM_PAGE_CACHE, kva);
+					cache_pages[cache_cnt++] = page;
+				}
+			}
+		}
+		if (page == NULL)
+			page = cache_evict (&retry);
+		if (page == NULL && retry)
+			continue;
+		if (page == NULL)
+			PANIC ("page cache: every page is pinned");
+		page->page_cache.base = key.base;
+		hash_insert (&cache_map, &page->page_cache.elem);
+		break;
+	}
+	page->page_cache.accessed = true;
+	page->page_cache.pin_cnt++;
+	return page;
+}
+
+/* Waits until no fill is in progress on pinned PAGE.  Must be
+ * called with cache_lock held; the lock is dropped while
+ * waiting. */
+static void
+cache_wait_io (struct page *page) {
+	while (page->page_cache.io_busy)
+		cond_wait (&io_done, &cache_lock);
+}
+
+/* Reads every invalid sector of pinned PAGE's group from disk.
+ * cache_lock is released during the read so that hits on other
+ * pages, and the reader a prefetch is running ahead of, are not
+ * held up behind the disk.  Must be called with cache_lock held
+ * and no fill in progress on PAGE. */
+static void
+cache_fill (struct page *page) {
+	struct page_cache *pc = &page->page_cache;
+
+	ASSERT (!pc->io_busy);
+	pc->io_busy = true;
+	lock_release (&cache_lock);
+	swap_in (page, pc->kva);
+	lock_acquire (&cache_lock);
+	pc->io_busy = false;
+	cond_broadcast (&io_done, &cache_lock);
+}
+
+/* Writes PAGE's dirty sectors back, completing partial ones from
+ * disk first.  Like cache_fill(), releases cache_lock during the
+ * I/O; PAGE is pinned so that it is not evicted meanwhile, and
+ * io_busy keeps readers and writers of it waiting until its dirty
+ * bits are clear.  Must be called with cache_lock held and no I/O
+ * in progress on PAGE. */
+static void
+cache_writeback (struct page *page) {
+	struct page_cache *pc = &page->page_cache;
+
+	ASSERT (!pc->io_busy);
+	if (pc->dirty == 0)
+		return;
+	pc->io_busy = true;
+	pc->pin_cnt++;
+	lock_release (&cache_lock);
+	swap_out (page);
+	lock_acquire (&cache_lock);
+	pc->pin_cnt--;
+	pc->io_busy = false;
+	cond_broadcast (&io_done, &cache_lock);
+}
+
+/* Reads SIZE bytes at offset OFS of SECTOR into BUFFER through
+ * the cache.  OFS + SIZE must not exceed DISK_SECTOR_SIZE. */
+void
+page_cache_read (disk_sector_t sector, void *buffer, off_t ofs, off_t size) {
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	struct page *page = cache_get (sector);
+	struct page_cache *pc = &page->page_cache;
+	size_t idx = sector - pc->base;
+
+	uint8_t bit = 1u << idx;
+
+	cache_wait_io (page);
+	if (!(pc->valid & bit)
+			&& !((pc->partial & bit) && ofs >= pc->lo[idx]
+				&& ofs + size <= pc->hi[idx]))
+		cache_fill (page);
+	memcpy (buffer, (uint8_t *) pc->kva + idx * DISK_SECTOR_SIZE + ofs, size);
+	pc->pin_cnt--;
+	lock_release (&cache_lock);
+}
+
+/* Writes SIZE bytes from BUFFER at offset OFS of SECTOR into the
+ * cache.  The sector reaches the disk later, from the flusher
+ * daemon, eviction, the last close of its file or
+ * page_cache_flush().  A write to a sector that is not cached
+ * only records the written range, so a run of small adjacent
+ * writes costs a memcpy each and at most one read, at
+ * writeback. */
+void
+page_cache_write (disk_sector_t sector, const void *buffer, off_t ofs,
+		off_t size) {
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	struct page *page = cache_get (sector);
+	struct page_cache *pc = &page->page_cache;
+	size_t idx = sector - pc->base;
+
+	uint8_t bit = 1u << idx;
+
+	cache_wait_io (page);
+	if (size == DISK_SECTOR_SIZE)
+		pc->partial &= ~bit;
+	else if (!(pc->valid & bit)) {
+		if (!(pc->partial & bit)) {
+			pc->partial |= bit;
+			pc->lo[idx] = ofs;
+			pc->hi[idx] = ofs + size;
+		} else if (ofs <= pc->hi[idx] && ofs + size >= pc->lo[idx]) {
+			/* Coalesce with the range written so far. */
+			if (ofs < pc->lo[idx])
+				pc->lo[idx] = ofs;
+			if (ofs + size > pc->hi[idx])
+				pc->hi[idx] = ofs + size;
+		} else
+			cache_fill (page);
+	}
+	memcpy ((uint8_t *) pc->kva + idx * DISK_SECTOR_SIZE + ofs, buffer, size);
+	if ((pc->partial & bit) && pc->lo[idx] == 0
+			&& pc->hi[idx] == DISK_SECTOR_SIZE)
+		pc->partial &= ~bit;
+	if (!(pc->partial & bit))
+		pc->valid |= bit;
+	pc->dirty |= bit;
+	pc->pin_cnt--;
+	lock_release (&cache_lock);
+}
+
+/* Asks the readahead daemon to bring SECTOR's group into the
+ * cache and returns without waiting.  Groups that are already
+ * fully cached are not queued. */
+void
+page_cache_prefetch (disk_sector_t sector) {
+	struct page_cache key;
+	struct hash_elem *e;
+	bool queued = false;
+
+	if (!cache_inited)
+		return;
+
+	lock_acquire (&cache_lock);
+	key.base = sector - sector % PAGE_CACHE_SECTORS;
+	e = hash_find (&cache_map, &key.elem);
+	if ((e == NULL || hash_entry (e, struct page_cache, elem)->valid
+				!= (1u << group_sectors (key.base)) - 1)
+			&& prefetch_cnt < PREFETCH_QUEUE) {
+		prefetch_queue[(prefetch_head + prefetch_cnt++) % PREFETCH_QUEUE] = sector;
+		queued = true;
+	}
+	lock_release (&cache_lock);
+	if (queued)
+		sema_up (&prefetch_sema);
+}
+
+/* Writes every dirty sector in the cache back to disk, one page
+ * at a time with cache_lock released during each write, so that
+ * hits on other pages go on meanwhile.  Pages with I/O in
+ * progress are skipped; their dirty sectors go out on the next
+ * flush. */
+void
+page_cache_flush (void) {
+	if (!cache_inited)
+		return;
+
+	lock_acquire (&cache_lock);
+	for (size_t i = 0; i < cache_cnt; i++)
+		if (!cache_pages[i]->page_cache.io_busy)
+			cache_writeback (cache_pages[i]);
+	lock_release (&cache_lock);
+}
+
+/* Writes back the dirty sectors among the CNT sectors starting
+ * at START, waiting out any I/O in progress on their pages. */
+void
+page_cache_flush_range (disk_sector_t start, size_t cnt) {
+	struct page_cache key;
+
+	if (!cache_inited || cnt == 0)
+		return;
+
+	lock_acquire (&cache_lock);
+	for (key.base = start - start % PAGE_CACHE_SECTORS; key.base < start + cnt;
+			key.base += PAGE_CACHE_SECTORS) {
+		struct hash_elem *e = hash_find (&cache_map, &key.elem);
+		if (e == NULL)
+			continue;
+		struct page *page = hash_entry (e, struct page, page_cache.elem);
+		page->page_cache.pin_cnt++;
+		cache_wait_io (page);
+		page->page_cache.pin_cnt--;
+		cache_writeback (page);
+	}
+	lock_release (&cache_lock);
 }
 
 /* Worker thread for page cache */
+/* Periodically writes dirty sectors, then dirty FAT sectors,
+ * back so that a crash loses at most FLUSH_INTERVAL ticks of
+ * writes. */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&flush_sema);
+		page_cache_flush ();
+		fat_flush ();
+	}
+}
+
+/* Flush timer callback, in the timer interrupt.  A beat the
+ * flusher is still busy with is not queued up behind it. */
+static void
+flush_tick (void *aux UNUSED) {
+	if (flush_sema.value == 0)
+		sema_up (&flush_sema);
+	ktimer_add (&flush_timer, flush_timer.deadline + FLUSH_INTERVAL);
+}
+
+/* Fills the groups queued by page_cache_prefetch().  Prefetched
+ * pages start without their accessed bit so that readahead the
+ * reader never gets to is the first thing the clock reclaims. */
+static void
+page_cache_kreadaheadd (void *aux UNUSED) {
+	struct page_cache key;
+
+	for (;;) {
+		sema_down (&prefetch_sema);
+
+		lock_acquire (&cache_lock);
+		disk_sector_t sector = prefetch_queue[prefetch_head];
+		prefetch_head = (prefetch_head + 1) % PREFETCH_QUEUE;
+		prefetch_cnt--;
+
+		key.base = sector - sector % PAGE_CACHE_SECTORS;
+		bool present = hash_find (&cache_map, &key.elem) != NULL;
+		struct page *page = cache_get (sector);
+		struct page_cache *pc = &page->page_cache;
+		if (!present)
+			pc->accessed = false;
+		cache_wait_io (page);
+		if (pc->valid != (1u << group_sectors (pc->base)) - 1)
+			cache_fill (page);
+		pc->pin_cnt--;
+		lock_release (&cache_lock);
+	}
 }
+#endif /* EFILESYS */
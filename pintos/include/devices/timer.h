@@ -1,17 +1,41 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+extern bool timer_tickless;
+
+/* A kernel timer.  Once added, FUNC (AUX) is called from the
+   timer interrupt at the start of tick DEADLINE, so it must not
+   sleep.  It may add its timer again. */
+typedef void ktimer_func (void *aux);
+struct ktimer
+  {
+    struct list_elem elem;      /* Element in a timer wheel slot. */
+    int64_t deadline;           /* Tick at which to fire. */
+    ktimer_func *func;          /* Function to call. */
+    void *aux;                  /* Argument for FUNC. */
+    bool pending;               /* Added, and not fired or cancelled. */
+  };
+
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
+void timer_set_deadline (int64_t deadline);
+int64_t timer_next_event (void);
+
+void ktimer_init (struct ktimer *, ktimer_func *, void *aux);
+void ktimer_add (struct ktimer *, int64_t deadline);
+bool ktimer_cancel (struct ktimer *);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
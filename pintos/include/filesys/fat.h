@@ -21,12 +21,14 @@ typedef uint32_t cluster_t;  /* Index of a cluster within FAT. */
 void fat_init (void);
 void fat_open (void);
 void fat_close (void);
+void fat_flush (void);
 void fat_create (void);
 void fat_close (void);
 
 cluster_t fat_create_chain (
     cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
 );
+size_t fat_create_run (cluster_t clst, size_t cnt, cluster_t *first);
 void fat_remove_chain (
     cluster_t clst, /* Cluster # to be removed */
     cluster_t pclst /* Previous cluster of clst, 0: clst is the start of chain */
@@ -34,5 +36,6 @@ void fat_remove_chain (
 cluster_t fat_get (cluster_t clst);
 void fat_put (cluster_t clst, cluster_t val);
 disk_sector_t cluster_to_sector (cluster_t clst);
+cluster_t sector_to_cluster (disk_sector_t sector);
 
 #endif /* filesys/fat.h */
@@ -2,6 +2,7 @@
 #define FILESYS_FSUTIL_H
 
 void fsutil_ls (char **argv);
+void fsutil_frag (char **argv);
 void fsutil_cat (char **argv);
 void fsutil_rm (char **argv);
 void fsutil_put (char **argv);
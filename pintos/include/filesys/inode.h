@@ -7,6 +7,15 @@
 
 struct bitmap;
 
+/* Read-ahead state of one open file.  A read that starts where
+ * the previous one ended grows WINDOW; any other read collapses
+ * it to zero. */
+struct inode_ra {
+	off_t next;                 /* Offset a sequential read would start at. */
+	off_t window;               /* Bytes to keep prefetched past NEXT. */
+	off_t async_end;            /* End of the range already queued. */
+};
+
 void inode_init (void);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
@@ -16,8 +25,11 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+void inode_readahead (struct inode *, struct inode_ra *, off_t offset,
+		off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+size_t inode_fragments (const struct inode *);
 
 #endif /* filesys/inode.h */
@@ -1,12 +1,47 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <hash.h>
+#include <stdint.h>
+#include "devices/disk.h"
+#include "filesys/off_t.h"
+#include "vm/uninit.h"
 
 struct page;
 enum vm_type;
 
-struct page_cache {};
+/* Number of consecutive sectors held by one page cache page. */
+#define PAGE_CACHE_SECTORS 8
+
+/* A page of the buffer cache.  It caches PAGE_CACHE_SECTORS
+ * consecutive sectors of the file system disk starting at BASE,
+ * each with its own valid and dirty bit.
+ *
+ * A small write to a sector that is not valid does not read it.
+ * The sector is marked partial instead and only bytes LO[i] up to
+ * HI[i] hold data; adjacent writes widen that range.  The rest of
+ * the sector is merged in from disk when it is first read or
+ * written back. */
+struct page_cache {
+	void *kva;                  /* Cached sector data. */
+	disk_sector_t base;         /* First sector (PAGE_CACHE_SECTORS aligned). */
+	uint8_t valid;              /* Bit i: sector BASE + i holds disk data. */
+	uint8_t dirty;              /* Bit i: sector BASE + i must be written. */
+	uint8_t partial;            /* Bit i: only LO[i]..HI[i] of it is valid. */
+	uint16_t lo[PAGE_CACHE_SECTORS];
+	uint16_t hi[PAGE_CACHE_SECTORS];
+	bool accessed;              /* Referenced since the clock hand passed. */
+	bool io_busy;               /* Being filled from disk without cache_lock. */
+	int pin_cnt;                /* Not evictable while nonzero. */
+	struct hash_elem elem;      /* Element in the sector lookup table. */
+};
 
 void page_cache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+
+void page_cache_read (disk_sector_t, void *buffer, off_t ofs, off_t size);
+void page_cache_write (disk_sector_t, const void *buffer, off_t ofs,
+		off_t size);
+void page_cache_prefetch (disk_sector_t);
+void page_cache_flush (void);
+void page_cache_flush_range (disk_sector_t, size_t cnt);
 #endif
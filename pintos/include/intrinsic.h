@@ -50,6 +50,22 @@ static __inline uint64_t rcr3(void) {
 	return val;
 }
 
+/* CR0 bit that makes supervisor-mode writes honor read-only
+   PTEs.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR0_WP 0x00010000
+
+__attribute__((always_inline))
+static __inline uint64_t rcr0(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr0,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr0(uint64_t val) {
+	__asm __volatile("movq %0, %%cr0" : : "r" (val));
+}
+
 __attribute__((always_inline))
 static __inline uint64_t rrax(void) {
 	uint64_t val;
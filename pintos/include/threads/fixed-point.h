@@ -0,0 +1,88 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point numbers, for the MLFQS scheduler's load
+   average and recent_cpu.  The kernel does no floating point.
+
+   Arguments named N are integers; arguments named X and Y are
+   fixed-point numbers. */
+typedef int32_t fixed_t;
+
+#define FP_SHIFT 14
+#define FP_ONE (1 << FP_SHIFT)
+
+/* Converts N to fixed point. */
+static inline fixed_t fp_from_int(int n)
+{
+	return n * FP_ONE;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int fp_trunc(fixed_t x)
+{
+	return x / FP_ONE;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int fp_round(fixed_t x)
+{
+	return x >= 0 ? (x + FP_ONE / 2) / FP_ONE : (x - FP_ONE / 2) / FP_ONE;
+}
+
+static inline fixed_t fp_add(fixed_t x, fixed_t y)
+{
+	return x + y;
+}
+
+static inline fixed_t fp_sub(fixed_t x, fixed_t y)
+{
+	return x - y;
+}
+
+static inline fixed_t fp_add_int(fixed_t x, int n)
+{
+	return x + n * FP_ONE;
+}
+
+static inline fixed_t fp_sub_int(fixed_t x, int n)
+{
+	return x - n * FP_ONE;
+}
+
+static inline fixed_t fp_mul(fixed_t x, fixed_t y)
+{
+	return ((int64_t)x) * y / FP_ONE;
+}
+
+static inline fixed_t fp_mul_int(fixed_t x, int n)
+{
+	return x * n;
+}
+
+static inline fixed_t fp_div(fixed_t x, fixed_t y)
+{
+	return ((int64_t)x) * FP_ONE / y;
+}
+
+static inline fixed_t fp_div_int(fixed_t x, int n)
+{
+	return x / n;
+}
+
+/* Returns X raised to the power N, N >= 0. */
+static inline fixed_t fp_pow(fixed_t x, int64_t n)
+{
+	fixed_t r = FP_ONE;
+
+	for (; n > 0; n >>= 1)
+	{
+		if (n & 1)
+			r = fp_mul(r, x);
+		x = fp_mul(x, x);
+	}
+	return r;
+}
+
+#endif /* threads/fixed-point.h */
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore
@@ -41,6 +42,79 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
+/* Reader-writer lock.
+   Any number of readers, or one writer.  A writer that is
+   waiting holds WRITER, so readers that arrive after it queue
+   behind it (writer preference) and both readers and writers
+   waiting on WRITER donate priority to its holder.  A writer
+   waiting for DRAINED donates in turn to every reader in
+   HOLDERS. */
+struct rwlock
+{
+	struct lock writer;			/* Held by the writer, or one waiting. */
+	struct semaphore drained;	/* Upped when the last reader leaves. */
+	unsigned readers;			/* Number of readers holding the lock. */
+	bool draining;				/* A writer waits for DRAINED. */
+	struct list holders;		/* Readers' struct rw_hold entries. */
+};
+
+/* One rwlock held for reading by a thread. */
+struct rw_hold
+{
+	struct list_elem elem;	/* Element in rwlock's HOLDERS. */
+	struct rwlock *rw;		/* The lock held. */
+	struct thread *thread;	/* The reader. */
+};
+
+void rw_init(struct rwlock *);
+void rw_read_acquire(struct rwlock *);
+bool rw_try_read(struct rwlock *);
+void rw_read_release(struct rwlock *);
+void rw_write_acquire(struct rwlock *);
+bool rw_try_write(struct rwlock *);
+void rw_write_release(struct rwlock *);
+bool rw_write_held_by_current_thread(const struct rwlock *);
+
+/* Sequence lock.
+   Readers take no lock: they note SEQ, read, and retry if SEQ
+   moved.  Writers run with interrupts off, so on this uniprocessor
+   a reader never finds a write in progress and never spins, and a
+   reader in an interrupt handler sees the data either before or
+   after a thread's write. */
+struct seqlock
+{
+	unsigned seq;				/* Odd while a write is in progress. */
+	enum intr_level old_level;	/* Writer's saved interrupt level. */
+};
+
+void seq_init(struct seqlock *);
+unsigned seq_read_begin(const struct seqlock *);
+bool seq_read_retry(const struct seqlock *, unsigned start);
+void seq_write_begin(struct seqlock *);
+void seq_write_end(struct seqlock *);
+
+/* Read-copy update.
+   A read-side critical section costs two stores to the running
+   thread.  It must not sleep (sema_down() and thread_block()
+   assert as much), and it is not preempted: a yield requested
+   inside it is put off until rcu_read_unlock().  So
+   on this uniprocessor no reader is ever switched out mid-section,
+   and a grace period has passed as soon as an updater runs
+   outside a section of its own. */
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+void synchronize_rcu(void);
+
+/* Loads a pointer published with rcu_assign_pointer(), inside a
+   read-side critical section. */
+#define rcu_dereference(P) \
+	({ typeof(P) _p = (P); barrier(); _p; })
+
+/* Publishes V through pointer P once everything V points to has
+   been initialized. */
+#define rcu_assign_pointer(P, V) \
+	do { barrier(); (P) = (V); } while (0)
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
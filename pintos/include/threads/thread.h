@@ -4,6 +4,8 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include "devices/timer.h"
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #ifdef VM
@@ -96,6 +98,10 @@ struct child_status {
 
 #define THREAD_NAME_MAX 16
 
+/* Rwlocks a thread can hold for reading at once.  Reading more
+   is a bug caught by an assertion, not a silent loss of donation. */
+#define RW_HOLD_MAX 4
+
 struct thread {
   /* Owned by thread.c. */
   tid_t tid;                  /* Thread identifier. */
@@ -105,10 +111,19 @@ struct thread {
   int priority;               /* Priority. */
   struct list donators;       /* donation list. */
   struct lock *waiting_lock;  /* wating lock. */
+  struct rwlock *waiting_rw;  /* Rwlock waited on for readers to leave. */
+  struct rw_hold rw_holds[RW_HOLD_MAX]; /* Rwlocks held for reading. */
+  int rw_hold_cnt;            /* Entries used in RW_HOLDS. */
   int64_t wakeup_tick;        /* ticks of wakeup. */
+  struct ktimer sleep_timer;  /* Wakes the thread at WAKEUP_TICK. */
+  int nice;                   /* MLFQS niceness. */
+  fixed_t recent_cpu;         /* MLFQS recent CPU use. */
+  int64_t decay_stamp;        /* Seconds of decay applied to RECENT_CPU. */
   /* Shared between thread.c and synch.c. */
   struct list_elem elem;          /* List element. */
   struct list_elem donation_elem; /* Donation list element. */
+  int rcu_nesting;                /* Depth of RCU read-side sections. */
+  bool rcu_yield;                 /* Yield put off until section ends. */
   int exit_status;
   struct list fds;
   bool fds_inited;
@@ -125,6 +140,7 @@ struct thread {
 
   // void *stack_pointer;
   void *stack_bottom;
+  size_t frame_cnt; /* 🅵 프레임에 올라와 있는 이 스레드의 페이지 수 (RSS, COW 공유 포함) */
 #endif
     uintptr_t rsp;  /* 유저 스택 포인터 저장용 */
 
@@ -141,14 +157,14 @@ extern bool thread_mlfqs;
 void thread_init(void);
 void thread_start(void);
 
-void thread_tick(void);
+void thread_tick(int64_t tick);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
 void thread_sleep(void);
-void awake_sleep_threads(int64_t tick);
+int64_t thread_next_deadline(int64_t now);
 
 void thread_block(void);
 void thread_unblock(struct thread *);
@@ -159,6 +175,7 @@ const char *thread_name(void);
 
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
+void thread_preemption(void);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
@@ -167,9 +184,12 @@ int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
+void thread_mlfqs_refresh(struct thread *);
 
 void donate(struct thread *thr, struct lock *l);
 void thread_restore_by_lock(struct lock *lock);
+void donate_readers(struct rwlock *rw);
+void thread_restore_by_rw(void);
 
 void do_iret(struct intr_frame *tf);
 
@@ -34,5 +34,3 @@ struct fd_elem
 
 bool init_fds(struct list *fds);
 void handle_exit(int status);
-
-extern struct lock filesys_lock;
\ No newline at end of file
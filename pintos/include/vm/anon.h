@@ -1,14 +1,21 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
+#include <bitmap.h>
 #include "vm/vm.h"
 struct page;
 enum vm_type;
 
+/* 🆉 내용이 전부 0 이라 디스크에 쓰지 않고 내려간 페이지의 swap_slot 값 */
+#define SWAP_SLOT_ZERO (BITMAP_ERROR - 1)
+
 struct anon_page {
     size_t swap_slot;   /* 스왑 슬롯 인덱스 */
 };
 
+extern size_t swap_readahead;
+
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_swap_share (struct page *dst, const struct page *src);
 
 #endif
@@ -58,6 +58,10 @@ struct page {
   /* Your implementation */
   struct hash_elem hash_elem;  // 🅢 hash_entry (해시에 넣기 위한 고정 슬롯)
   bool writable;               // 🅕 페이지 쓰기 가능 여부
+  struct list_elem frame_elem; // 🅲 frame->sharers 에 매달리는 슬롯 (COW 공유)
+  struct thread *owner;        // 🅵 이 페이지를 SPT 에 가진 스레드 (퇴출 시 owner 의 pml4 를 본다)
+  uint64_t ghost_seq;          // 🅠 2Q: A1in 에서 쫓겨난 시점 (0 이면 ghost 아님)
+  bool zero_mapped;            // 🆉 frame 없이 공유 zero 프레임이 읽기 전용으로 걸려 있음
 
   /* Per-type data are binded into the union.
    * Each function automatically detects the current union */
@@ -72,11 +76,41 @@ struct page {
 };
 
 /* The representation of "frame" */
+/* 🅵 user pool 페이지 번호로 인덱싱되는 frame_table[] 의 한 칸. 미리 할당돼 있어
+ * 폴트 경로에서 malloc 하지 않는다. owner/pml4 는 대표 페이지(page)의 주인 것이다. */
 struct frame {
   void *kva;
   struct page *page;
+  struct thread *owner;    /* 🅵 대표 페이지의 주인 스레드 */
+  uint64_t *pml4;          /* 🅵 owner 의 pml4 (accessed/dirty 비트는 여기서 본다) */
+  struct list sharers;     /* 🅲 이 프레임을 매핑한 페이지들 (page->frame_elem) */
+  int share_cnt;           /* 🅲 sharers 길이. 1 보다 크면 COW 로 읽기 전용 공유 중 */
+  int pin_cnt;             /* 🅵 0 보다 크면 퇴출 금지 (swap_in/복사 진행 중) */
+  uint8_t flags;           /* 🅵 FRAME_* */
+  struct list_elem q_elem; /* 🅠 2Q 의 A1in / Am 큐 슬롯 */
 };
 
+#define FRAME_USED 0x1 /* 🅵 palloc 으로 받아 사용 중인 슬롯 */
+#define FRAME_A1IN 0x2 /* 🅠 2Q: 처음 올라온 프레임 (FIFO) */
+#define FRAME_AM 0x4   /* 🅠 2Q: ghost 에서 되돌아온 hot 프레임 (second-chance) */
+#define FRAME_EVICTING 0x8 /* 🅿 swap_out I/O 진행 중 (frame_lock 없이) */
+
+/* 🅠 페이지 교체 정책. 커널 옵션 -vm-policy=clock|2q 로 고른다. */
+enum vm_policy {
+  VM_POLICY_CLOCK, /* 단일 second-chance (기본값) */
+  VM_POLICY_2Q,    /* A1in FIFO + Am clock + A1out ghost, 순차 스캔에 강함 */
+};
+extern enum vm_policy vm_policy;
+
+/* 🅿 pageout 데몬 워터마크 (여유 user 프레임 수, 커널 옵션 -vm-wm=LOW,HIGH) */
+extern size_t vm_free_low, vm_free_high;
+
+/* 🅵 kva → frame 역참조 (O(1)). user pool 밖의 주소면 NULL. */
+struct frame *vm_frame_lookup(void *kva);
+/* 🆁 swap readahead: 퇴출 없이 물리적으로 이어진 여유 프레임들을 잡고, 채운 뒤 매핑한다. */
+size_t vm_prefetch_frames(struct page **pages, size_t cnt);
+bool vm_prefetch_done(struct page *page);
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -110,6 +144,7 @@ bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
 void vm_init(void);
+void vm_print_stats(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
                          bool write, bool not_present);
 
@@ -119,6 +154,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
                                     bool writable, vm_initializer *init,
                                     void *aux);
 void vm_dealloc_page(struct page *page);
+void vm_release_frame(struct page *page);
 bool vm_claim_page(void *va);
 bool lazy_load_segment(struct page *page, void *aux);
 enum vm_type page_get_type(struct page *page);
@@ -0,0 +1,90 @@
+/* Looks names up before they exist, after they are created, after
+   they are removed and after they are created again, over more names
+   than the directory entry cache holds.  A cached miss must not hide
+   a new file, and a cached hit must not outlive its file. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define NAME_CNT 100
+
+static void
+make_file (const char *name, char tag) 
+{
+  int fd;
+
+  if (!create (name, 1))
+    fail ("create \"%s\" failed", name);
+  if ((fd = open (name)) < 2)
+    fail ("open \"%s\" failed", name);
+  if (write (fd, &tag, 1) != 1)
+    fail ("write \"%s\" failed", name);
+  close (fd);
+}
+
+static void
+check_file_tag (const char *name, char tag) 
+{
+  char data;
+  int fd;
+
+  if ((fd = open (name)) < 2)
+    fail ("open \"%s\" failed", name);
+  if (read (fd, &data, 1) != 1 || data != tag)
+    fail ("\"%s\" has the wrong contents", name);
+  close (fd);
+}
+
+static void
+check_missing (const char *name) 
+{
+  if (open (name) != -1)
+    fail ("missing file \"%s\" can be opened", name);
+}
+
+void
+test_main (void) 
+{
+  char name[16];
+  int i;
+
+  for (i = 0; i < NAME_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "n%03d", i);
+      check_missing (name);
+      check_missing (name);
+    }
+  msg ("look up missing names");
+
+  for (i = 0; i < NAME_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "n%03d", i);
+      make_file (name, (char) i);
+      check_file_tag (name, (char) i);
+    }
+  msg ("create and open files");
+
+  for (i = 0; i < NAME_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "n%03d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+      check_missing (name);
+    }
+  msg ("remove files");
+
+  for (i = NAME_CNT - 1; i >= 0; i--) 
+    {
+      snprintf (name, sizeof name, "n%03d", i);
+      make_file (name, (char) (i + NAME_CNT));
+    }
+  for (i = 0; i < NAME_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "n%03d", i);
+      check_file_tag (name, (char) (i + NAME_CNT));
+    }
+  msg ("create files again");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-cache) begin
+(dir-cache) look up missing names
+(dir-cache) create and open files
+(dir-cache) remove files
+(dir-cache) create files again
+(dir-cache) end
+EOF
+pass;
@@ -0,0 +1,82 @@
+/* Creates enough files in the root directory that it has to grow
+   several times, removes every other one, and checks that each
+   name still leads to the right file or to nothing.  Then creates
+   the removed names again. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 200
+
+static void
+make_file (int i) 
+{
+  char name[16];
+  int fd;
+
+  snprintf (name, sizeof name, "f%03d", i);
+  if (!create (name, 0))
+    fail ("create \"%s\" failed", name);
+  if ((fd = open (name)) < 2)
+    fail ("open \"%s\" failed", name);
+  if (write (fd, name, sizeof name) != sizeof name)
+    fail ("write \"%s\" failed", name);
+  close (fd);
+}
+
+static void
+check_files (int step) 
+{
+  char name[16], data[16];
+  int i, fd;
+
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "f%03d", i);
+      fd = open (name);
+      if (i % step != 0) 
+        {
+          if (fd != -1)
+            fail ("removed file \"%s\" can still be opened", name);
+          continue;
+        }
+      if (fd < 2)
+        fail ("open \"%s\" failed", name);
+      if (read (fd, data, sizeof data) != sizeof data
+          || strcmp (data, name))
+        fail ("\"%s\" has the wrong contents", name);
+      close (fd);
+    }
+}
+
+void
+test_main (void) 
+{
+  char name[16];
+  int i;
+
+  for (i = 0; i < FILE_CNT; i++)
+    make_file (i);
+  msg ("create %d files", FILE_CNT);
+  check_files (1);
+  msg ("verify %d files", FILE_CNT);
+
+  for (i = 1; i < FILE_CNT; i += 2) 
+    {
+      snprintf (name, sizeof name, "f%03d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  msg ("remove odd-numbered files");
+  check_files (2);
+  msg ("verify even-numbered files");
+
+  for (i = 1; i < FILE_CNT; i += 2)
+    make_file (i);
+  msg ("create odd-numbered files again");
+  check_files (1);
+  msg ("verify %d files", FILE_CNT);
+}
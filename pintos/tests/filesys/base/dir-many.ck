@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-many) begin
+(dir-many) create 200 files
+(dir-many) verify 200 files
+(dir-many) remove odd-numbered files
+(dir-many) verify even-numbered files
+(dir-many) create odd-numbered files again
+(dir-many) verify 200 files
+(dir-many) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Grows an empty file by writing past its end, which must leave
+   a zero-filled hole, then keeps appending blocks of varying size
+   until the file spans many sectors.  The file is closed and
+   reopened after each phase and must read back exactly. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HOLE_SIZE 40000
+#define TEST_SIZE (200 * 1024)
+
+static const char file_name[] = "grower";
+static char buf[TEST_SIZE];
+
+void
+test_main (void) 
+{
+  size_t ofs;
+  int fd;
+
+  random_init (11);
+  random_bytes (buf + HOLE_SIZE, sizeof buf - HOLE_SIZE);
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  seek (fd, HOLE_SIZE);
+  CHECK (write (fd, buf + HOLE_SIZE, 1000) == 1000,
+         "write past end of \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  check_file (file_name, buf, HOLE_SIZE + 1000);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  seek (fd, HOLE_SIZE + 1000);
+  for (ofs = HOLE_SIZE + 1000; ofs < sizeof buf; )
+    {
+      size_t block_size = random_ulong () % 4000 + 1;
+      if (block_size > sizeof buf - ofs)
+        block_size = sizeof buf - ofs;
+      if (write (fd, buf + ofs, block_size) != (int) block_size)
+        fail ("write %zu bytes at offset %zu failed", block_size, ofs);
+      ofs += block_size;
+    }
+  msg ("append to \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  check_file (file_name, buf, sizeof buf);
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-reopen) begin
+(grow-reopen) create "grower"
+(grow-reopen) open "grower"
+(grow-reopen) write past end of "grower"
+(grow-reopen) close "grower"
+(grow-reopen) open "grower" for verification
+(grow-reopen) verified contents of "grower"
+(grow-reopen) close "grower"
+(grow-reopen) open "grower"
+(grow-reopen) append to "grower"
+(grow-reopen) close "grower"
+(grow-reopen) open "grower" for verification
+(grow-reopen) verified contents of "grower"
+(grow-reopen) close "grower"
+(grow-reopen) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Opens one file twice and checks that both handles see the same
+   inode.  Removes the file while it is open, recreates the name,
+   and checks that the old handles and the new file stay apart. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int fd1, fd2, fd3;
+  char c;
+
+  CHECK (create ("shared", 1), "create \"shared\"");
+  CHECK ((fd1 = open ("shared")) > 1, "open \"shared\" once");
+  CHECK ((fd2 = open ("shared")) > 1, "open \"shared\" twice");
+  c = 'x';
+  CHECK (write (fd1, &c, 1) == 1, "write through first handle");
+  CHECK (read (fd2, &c, 1) == 1 && c == 'x', "read through second handle");
+
+  CHECK (remove ("shared"), "remove \"shared\"");
+  CHECK (create ("shared", 1), "create \"shared\" again");
+  CHECK ((fd3 = open ("shared")) > 1, "open new \"shared\"");
+  CHECK (read (fd3, &c, 1) == 1 && c == 0, "new \"shared\" is empty");
+
+  c = 'y';
+  seek (fd1, 0);
+  CHECK (write (fd1, &c, 1) == 1, "write through removed file's handle");
+  seek (fd2, 0);
+  CHECK (read (fd2, &c, 1) == 1 && c == 'y',
+         "read through removed file's other handle");
+  seek (fd3, 0);
+  CHECK (read (fd3, &c, 1) == 1 && c == 0, "new \"shared\" is still empty");
+
+  msg ("close all handles");
+  close (fd1);
+  close (fd2);
+  close (fd3);
+  CHECK ((fd3 = open ("shared")) > 1, "open new \"shared\" again");
+  CHECK (read (fd3, &c, 1) == 1 && c == 0, "new \"shared\" is still empty");
+  close (fd3);
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(open-same) begin
+(open-same) create "shared"
+(open-same) open "shared" once
+(open-same) open "shared" twice
+(open-same) write through first handle
+(open-same) read through second handle
+(open-same) remove "shared"
+(open-same) create "shared" again
+(open-same) open new "shared"
+(open-same) new "shared" is empty
+(open-same) write through removed file's handle
+(open-same) read through removed file's other handle
+(open-same) new "shared" is still empty
+(open-same) close all handles
+(open-same) open new "shared" again
+(open-same) new "shared" is still empty
+(open-same) end
+EOF
+pass;
@@ -0,0 +1,93 @@
+/* Runs several processes at once that each write and read back a
+   file of their own, read a file they all share, and create and
+   remove names in the same directory.  None of them may see another
+   process's data or lose its own. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define FILE_SIZE (20 * 1024)
+#define BLOCK_SIZE 512
+#define ROUNDS 20
+
+static char shared[FILE_SIZE];
+
+static int
+child_main (int id) 
+{
+  char name[16], block[BLOCK_SIZE];
+  size_t ofs;
+  int fd, round;
+
+  snprintf (name, sizeof name, "own%d", id);
+  if (!create (name, 0) || (fd = open (name)) < 2)
+    return -1;
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE) 
+    {
+      memset (block, (char) (ofs / BLOCK_SIZE * CHILD_CNT + id), BLOCK_SIZE);
+      if (write (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+        return -1;
+    }
+  close (fd);
+
+  for (round = 0; round < ROUNDS; round++) 
+    {
+      char temp[16];
+
+      snprintf (temp, sizeof temp, "tmp%d-%d", id, round);
+      if (!create (temp, BLOCK_SIZE) || !remove (temp))
+        return -1;
+
+      if ((fd = open ("shared")) < 2)
+        return -1;
+      seek (fd, round * BLOCK_SIZE);
+      if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE
+          || memcmp (block, shared + round * BLOCK_SIZE, BLOCK_SIZE))
+        return -1;
+      close (fd);
+    }
+
+  if ((fd = open (name)) < 2)
+    return -1;
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE) 
+    {
+      size_t i;
+
+      if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+        return -1;
+      for (i = 0; i < BLOCK_SIZE; i++)
+        if (block[i] != (char) (ofs / BLOCK_SIZE * CHILD_CNT + id))
+          return -1;
+    }
+  close (fd);
+  return id;
+}
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+  int fd, i;
+
+  random_bytes (shared, sizeof shared);
+  CHECK (create ("shared", sizeof shared), "create \"shared\"");
+  CHECK ((fd = open ("shared")) > 1, "open \"shared\"");
+  CHECK (write (fd, shared, sizeof shared) == sizeof shared,
+         "write \"shared\"");
+  msg ("close \"shared\"");
+  close (fd);
+
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      children[i] = fork ("child");
+      if (children[i] == 0)
+        exit (child_main (i));
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (children[i]) == i, "wait for child %d", i);
+}
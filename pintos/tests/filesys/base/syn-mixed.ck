@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(syn-mixed) begin
+(syn-mixed) create "shared"
+(syn-mixed) open "shared"
+(syn-mixed) write "shared"
+(syn-mixed) close "shared"
+(syn-mixed) wait for child 0
+(syn-mixed) wait for child 1
+(syn-mixed) wait for child 2
+(syn-mixed) wait for child 3
+(syn-mixed) end
+EOF
+pass;
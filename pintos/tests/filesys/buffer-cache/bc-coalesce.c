@@ -0,0 +1,40 @@
+/* Writes a file one byte at a time.  The buffer cache must gather
+   the bytes into whole sectors instead of writing each one through
+   to disk.  Then writes a fresh block and closes the file: closing
+   the last handle must push the block to disk right away, not wait
+   for the periodic flush. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define TEST_SIZE 4096
+
+static const char file_name[] = "data";
+static char buf[TEST_SIZE];
+
+void
+test_main (void) {
+  size_t i;
+  int fd;
+  long long write_cnt;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, 2 * TEST_SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+
+  write_cnt = get_fs_disk_write_cnt ();
+  for (i = 0; i < TEST_SIZE; i++)
+    if (write (fd, buf + i, 1) != 1)
+      fail ("write 1 byte at offset %zu failed", i);
+  msg ("write \"%s\" one byte at a time", file_name);
+  CHECK (get_fs_disk_write_cnt () - write_cnt < TEST_SIZE / 16,
+         "check write_cnt");
+
+  write_cnt = get_fs_disk_write_cnt ();
+  CHECK (write (fd, buf, TEST_SIZE) == TEST_SIZE, "write \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  CHECK (get_fs_disk_write_cnt () >= write_cnt + TEST_SIZE / 512,
+         "check write_cnt after close");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-coalesce) begin
+(bc-coalesce) create "data"
+(bc-coalesce) open "data"
+(bc-coalesce) write "data" one byte at a time
+(bc-coalesce) check write_cnt
+(bc-coalesce) write "data"
+(bc-coalesce) close "data"
+(bc-coalesce) check write_cnt after close
+(bc-coalesce) end
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Writes a file that fits in the buffer cache, reads it back once,
+   then reads it again.  The second pass must be served entirely
+   from the cache, without reading the file system disk. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define TEST_SIZE (16 * 1024)
+
+static const char file_name[] = "data";
+static char buf[TEST_SIZE];
+
+void
+test_main (void) {
+  int fd;
+  long long read_cnt;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, sizeof buf), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf, "write \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+
+  check_file (file_name, buf, sizeof buf);
+
+  read_cnt = get_fs_disk_read_cnt ();
+  check_file (file_name, buf, sizeof buf);
+  CHECK (get_fs_disk_read_cnt () == read_cnt, "check read_cnt");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-reread) begin
+(bc-reread) create "data"
+(bc-reread) open "data"
+(bc-reread) write "data"
+(bc-reread) close "data"
+(bc-reread) open "data" for verification
+(bc-reread) verified contents of "data"
+(bc-reread) close "data"
+(bc-reread) open "data" for verification
+(bc-reread) verified contents of "data"
+(bc-reread) close "data"
+(bc-reread) check read_cnt
+(bc-reread) end
+EOF
+pass;
@@ -0,0 +1,47 @@
+/* Writes a file several times larger than the buffer cache, then
+   reads it back from start to end.  Read-ahead may fetch sectors
+   before they are asked for, but every sector should come off the
+   file system disk about once. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define TEST_SIZE (512 * 1024)
+#define BLOCK_SIZE 4096
+
+static const char file_name[] = "data";
+static char buf[TEST_SIZE];
+
+void
+test_main (void) {
+  char block[BLOCK_SIZE];
+  size_t ofs;
+  int fd;
+  long long read_cnt;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, sizeof buf), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (ofs = 0; ofs < sizeof buf; ofs += BLOCK_SIZE)
+    if (write (fd, buf + ofs, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("write %d bytes at offset %zu failed", BLOCK_SIZE, ofs);
+  msg ("write \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  read_cnt = get_fs_disk_read_cnt ();
+  for (ofs = 0; ofs < sizeof buf; ofs += BLOCK_SIZE) {
+    if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("read %d bytes at offset %zu failed", BLOCK_SIZE, ofs);
+    compare_bytes (block, buf + ofs, BLOCK_SIZE, ofs, file_name);
+  }
+  msg ("read \"%s\" sequentially", file_name);
+
+  /* Leave room for metadata and for read-ahead past the end. */
+  CHECK (get_fs_disk_read_cnt () - read_cnt <= TEST_SIZE / 512 + 64,
+         "check read_cnt");
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
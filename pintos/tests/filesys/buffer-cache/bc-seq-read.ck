@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-seq-read) begin
+(bc-seq-read) create "data"
+(bc-seq-read) open "data"
+(bc-seq-read) write "data"
+(bc-seq-read) close "data"
+(bc-seq-read) open "data"
+(bc-seq-read) read "data" sequentially
+(bc-seq-read) check read_cnt
+(bc-seq-read) close "data"
+(bc-seq-read) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Writes a row of small files, removes every other one, and then
+   writes a file larger than any of the holes they left, so the
+   allocator has to choose between splitting it across holes and
+   taking free space elsewhere.  All surviving files must read back
+   intact. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define SMALL_CNT 8
+#define SMALL_SIZE (64 * 1024)
+#define BIG_SIZE (512 * 1024)
+#define BLOCK_SIZE 4096
+
+static char small[SMALL_SIZE];
+static char big[BIG_SIZE];
+
+static void
+write_file (const char *file_name, const char *buf, size_t size) {
+  size_t ofs;
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (ofs = 0; ofs < size; ofs += BLOCK_SIZE)
+    if (write (fd, buf + ofs, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("write %d bytes at offset %zu in \"%s\" failed",
+            BLOCK_SIZE, ofs, file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
+
+void
+test_main (void) {
+  char file_name[16];
+  int i;
+
+  random_init (13);
+  random_bytes (small, sizeof small);
+  random_bytes (big, sizeof big);
+
+  for (i = 0; i < SMALL_CNT; i++) {
+    snprintf (file_name, sizeof file_name, "small%d", i);
+    write_file (file_name, small, sizeof small);
+  }
+  for (i = 0; i < SMALL_CNT; i += 2) {
+    snprintf (file_name, sizeof file_name, "small%d", i);
+    CHECK (remove (file_name), "remove \"%s\"", file_name);
+  }
+
+  write_file ("big", big, sizeof big);
+  check_file ("big", big, sizeof big);
+  for (i = 1; i < SMALL_CNT; i += 2) {
+    snprintf (file_name, sizeof file_name, "small%d", i);
+    check_file (file_name, small, sizeof small);
+  }
+}
@@ -0,0 +1,55 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fat-holes) begin
+(fat-holes) create "small0"
+(fat-holes) open "small0"
+(fat-holes) close "small0"
+(fat-holes) create "small1"
+(fat-holes) open "small1"
+(fat-holes) close "small1"
+(fat-holes) create "small2"
+(fat-holes) open "small2"
+(fat-holes) close "small2"
+(fat-holes) create "small3"
+(fat-holes) open "small3"
+(fat-holes) close "small3"
+(fat-holes) create "small4"
+(fat-holes) open "small4"
+(fat-holes) close "small4"
+(fat-holes) create "small5"
+(fat-holes) open "small5"
+(fat-holes) close "small5"
+(fat-holes) create "small6"
+(fat-holes) open "small6"
+(fat-holes) close "small6"
+(fat-holes) create "small7"
+(fat-holes) open "small7"
+(fat-holes) close "small7"
+(fat-holes) remove "small0"
+(fat-holes) remove "small2"
+(fat-holes) remove "small4"
+(fat-holes) remove "small6"
+(fat-holes) create "big"
+(fat-holes) open "big"
+(fat-holes) close "big"
+(fat-holes) open "big" for verification
+(fat-holes) verified contents of "big"
+(fat-holes) close "big"
+(fat-holes) open "small1" for verification
+(fat-holes) verified contents of "small1"
+(fat-holes) close "small1"
+(fat-holes) open "small3" for verification
+(fat-holes) verified contents of "small3"
+(fat-holes) close "small3"
+(fat-holes) open "small5" for verification
+(fat-holes) verified contents of "small5"
+(fat-holes) close "small5"
+(fat-holes) open "small7" for verification
+(fat-holes) verified contents of "small7"
+(fat-holes) close "small7"
+(fat-holes) end
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Grows several files in turn, a block at a time, so their FAT
+   chains interleave across the disk.  Then reads each file at
+   random offsets, which must find the right cluster however far
+   into the chain it is, and finally reads each file in full. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define FILE_CNT 4
+#define FILE_SIZE (64 * 1024)
+#define BLOCK_SIZE 1500
+#define READ_CNT 200
+#define READ_SIZE 100
+
+static char bufs[FILE_CNT][FILE_SIZE];
+
+void
+test_main (void) {
+  char file_names[FILE_CNT][16];
+  char block[READ_SIZE];
+  int fds[FILE_CNT];
+  size_t ofs;
+  int i, j;
+
+  random_init (12);
+  for (i = 0; i < FILE_CNT; i++) {
+    snprintf (file_names[i], sizeof file_names[i], "file%d", i);
+    random_bytes (bufs[i], FILE_SIZE);
+    CHECK (create (file_names[i], 0), "create \"%s\"", file_names[i]);
+    CHECK ((fds[i] = open (file_names[i])) > 1, "open \"%s\"", file_names[i]);
+  }
+
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE) {
+    size_t size = FILE_SIZE - ofs < BLOCK_SIZE ? FILE_SIZE - ofs : BLOCK_SIZE;
+    for (i = 0; i < FILE_CNT; i++)
+      if (write (fds[i], bufs[i] + ofs, size) != (int) size)
+        fail ("write %zu bytes at offset %zu in \"%s\" failed",
+              size, ofs, file_names[i]);
+  }
+  msg ("grow files in turn");
+
+  for (j = 0; j < READ_CNT; j++)
+    for (i = 0; i < FILE_CNT; i++) {
+      ofs = random_ulong () % (FILE_SIZE - READ_SIZE);
+      seek (fds[i], ofs);
+      if (read (fds[i], block, READ_SIZE) != READ_SIZE)
+        fail ("read %d bytes at offset %zu in \"%s\" failed",
+              READ_SIZE, ofs, file_names[i]);
+      compare_bytes (block, bufs[i] + ofs, READ_SIZE, ofs, file_names[i]);
+    }
+  msg ("read files at random offsets");
+
+  for (i = 0; i < FILE_CNT; i++) {
+    msg ("close \"%s\"", file_names[i]);
+    close (fds[i]);
+    check_file (file_names[i], bufs[i], FILE_SIZE);
+  }
+}
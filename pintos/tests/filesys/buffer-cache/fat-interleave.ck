@@ -0,0 +1,35 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fat-interleave) begin
+(fat-interleave) create "file0"
+(fat-interleave) open "file0"
+(fat-interleave) create "file1"
+(fat-interleave) open "file1"
+(fat-interleave) create "file2"
+(fat-interleave) open "file2"
+(fat-interleave) create "file3"
+(fat-interleave) open "file3"
+(fat-interleave) grow files in turn
+(fat-interleave) read files at random offsets
+(fat-interleave) close "file0"
+(fat-interleave) open "file0" for verification
+(fat-interleave) verified contents of "file0"
+(fat-interleave) close "file0"
+(fat-interleave) close "file1"
+(fat-interleave) open "file1" for verification
+(fat-interleave) verified contents of "file1"
+(fat-interleave) close "file1"
+(fat-interleave) close "file2"
+(fat-interleave) open "file2" for verification
+(fat-interleave) verified contents of "file2"
+(fat-interleave) close "file2"
+(fat-interleave) close "file3"
+(fat-interleave) open "file3" for verification
+(fat-interleave) verified contents of "file3"
+(fat-interleave) close "file3"
+(fat-interleave) end
+EOF
+pass;
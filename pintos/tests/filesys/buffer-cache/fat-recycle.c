@@ -0,0 +1,64 @@
+/* Creates, fills and removes a file over and over, allocating many
+   times the size of the disk in total, then writes one file that
+   needs most of the disk.  It only fits if every removal returned
+   its clusters to the FAT. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#define CYCLE_CNT 20
+#define CYCLE_SIZE (512 * 1024)
+#define BIG_SIZE (1536 * 1024)
+#define BLOCK_SIZE 4096
+
+static char block[BLOCK_SIZE];
+
+/* Writes SIZE bytes to FILE_NAME, each block filled with a byte
+   derived from SEED and the block's index. */
+static void
+write_file (const char *file_name, size_t size, int seed) {
+  size_t ofs;
+  int fd;
+
+  if (!create (file_name, 0))
+    fail ("create \"%s\" failed", file_name);
+  if ((fd = open (file_name)) < 2)
+    fail ("open \"%s\" failed", file_name);
+  for (ofs = 0; ofs < size; ofs += BLOCK_SIZE) {
+    memset (block, (char) (ofs / BLOCK_SIZE + seed), BLOCK_SIZE);
+    if (write (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("write %d bytes at offset %zu in \"%s\" failed",
+            BLOCK_SIZE, ofs, file_name);
+  }
+  close (fd);
+}
+
+void
+test_main (void) {
+  size_t ofs, i;
+  int cycle, fd;
+
+  for (cycle = 0; cycle < CYCLE_CNT; cycle++) {
+    write_file ("temp", CYCLE_SIZE, cycle);
+    if (!remove ("temp"))
+      fail ("remove \"temp\" failed");
+  }
+  msg ("create, write and remove \"temp\" %d times", CYCLE_CNT);
+
+  write_file ("big", BIG_SIZE, 0);
+  msg ("write \"big\"");
+
+  CHECK ((fd = open ("big")) > 1, "open \"big\" for verification");
+  for (ofs = 0; ofs < BIG_SIZE; ofs += BLOCK_SIZE) {
+    if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("read %d bytes at offset %zu in \"big\" failed", BLOCK_SIZE, ofs);
+    for (i = 0; i < BLOCK_SIZE; i++)
+      if (block[i] != (char) (ofs / BLOCK_SIZE))
+        fail ("byte %zu in \"big\" differs", ofs + i);
+  }
+  msg ("verified contents of \"big\"");
+  msg ("close \"big\"");
+  close (fd);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fat-recycle) begin
+(fat-recycle) create, write and remove "temp" 20 times
+(fat-recycle) write "big"
+(fat-recycle) open "big" for verification
+(fat-recycle) verified contents of "big"
+(fat-recycle) close "big"
+(fat-recycle) end
+EOF
+pass;
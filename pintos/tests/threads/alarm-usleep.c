@@ -0,0 +1,51 @@
+/* Checks that sub-tick sleeps last at least as long as asked,
+   and that they block, letting a lower-priority thread run,
+   instead of spinning. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Sleep lengths, in microseconds, all shorter than a tick. */
+static const int sleeps[] = {500, 2000, 5000, 9000};
+#define SLEEP_CNT (sizeof sleeps / sizeof *sleeps)
+
+static thread_func spin_thread;
+static volatile bool done;
+static volatile int64_t spins;
+
+void
+test_alarm_usleep (void) 
+{
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_create ("spinner", PRI_DEFAULT - 1, spin_thread, NULL);
+
+  for (i = 0; i < SLEEP_CNT; i++) 
+    {
+      int64_t before_spins = spins;
+      int64_t start = timer_ns ();
+
+      timer_usleep (sleeps[i]);
+      if (timer_ns () - start < sleeps[i] * 1000)
+        fail ("Sleep of %d us woke up early.", sleeps[i]);
+      if (spins == before_spins)
+        fail ("Sleep of %d us did not yield the CPU.", sleeps[i]);
+      msg ("Slept %d us.", sleeps[i]);
+    }
+
+  done = true;
+  timer_msleep (10);
+}
+
+static void
+spin_thread (void *aux UNUSED) 
+{
+  while (!done)
+    spins++;
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-usleep) begin
+(alarm-usleep) Slept 500 us.
+(alarm-usleep) Slept 2000 us.
+(alarm-usleep) Slept 5000 us.
+(alarm-usleep) Slept 9000 us.
+(alarm-usleep) end
+EOF
+pass;
@@ -0,0 +1,91 @@
+/* Checks that sleeps and kernel timers fire in deadline order,
+   and not early, across the levels of the timer wheel, and that a
+   cancelled kernel timer does not fire. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Sleep lengths, in ticks, given to threads in this order.  They
+   reach the first and second wheels and the boundary between. */
+static const int sleeps[] = {200, 1, 65, 300, 63, 128, 64};
+#define SLEEP_CNT (sizeof sleeps / sizeof *sleeps)
+
+static thread_func alarm_wheel_thread;
+static ktimer_func fire;
+static int64_t start_time;
+static struct semaphore done_sema;
+static struct semaphore fired_sema;
+static bool cancelled_fired;
+
+void
+test_alarm_wheel (void) 
+{
+  struct ktimer timer, cancelled;
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done_sema, 0);
+  sema_init (&fired_sema, 0);
+
+  /* Start at the very beginning of a timer tick. */
+  start_time = timer_ticks ();
+  while (timer_elapsed (start_time) == 0)
+    continue;
+  start_time = timer_ticks ();
+
+  ktimer_init (&timer, fire, &fired_sema);
+  ktimer_add (&timer, start_time + 100);
+  ktimer_init (&cancelled, fire, NULL);
+  ktimer_add (&cancelled, start_time + 150);
+
+  for (i = 0; i < SLEEP_CNT; i++) 
+    thread_create ("sleeper", PRI_DEFAULT + 1, alarm_wheel_thread,
+                   (void *) &sleeps[i]);
+
+  if (!ktimer_cancel (&cancelled))
+    fail ("ktimer_cancel() found no pending timer.");
+
+  sema_down (&fired_sema);
+  msg ("Kernel timer fired.");
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    sema_down (&done_sema);
+  if (cancelled_fired)
+    fail ("Cancelled timer fired.");
+}
+
+static void
+alarm_wheel_thread (void *ticks_) 
+{
+  int ticks = *(const int *) ticks_;
+  int64_t woke;
+
+  timer_sleep (start_time + ticks - timer_ticks ());
+  woke = timer_elapsed (start_time);
+  if (woke < ticks)
+    msg ("Thread sleeping %d ticks woke up %"PRId64" early.",
+         ticks, ticks - woke);
+  else
+    msg ("Thread sleeping %d ticks woke up.", ticks);
+
+  sema_up (&done_sema);
+}
+
+/* Kernel timer callback.  Ups SEMA_, or records that the
+   cancelled timer fired. */
+static void
+fire (void *sema_) 
+{
+  if (sema_ != NULL)
+    sema_up (sema_);
+  else
+    cancelled_fired = true;
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-wheel) begin
+(alarm-wheel) Thread sleeping 1 ticks woke up.
+(alarm-wheel) Thread sleeping 63 ticks woke up.
+(alarm-wheel) Thread sleeping 64 ticks woke up.
+(alarm-wheel) Thread sleeping 65 ticks woke up.
+(alarm-wheel) Kernel timer fired.
+(alarm-wheel) Thread sleeping 128 ticks woke up.
+(alarm-wheel) Thread sleeping 200 ticks woke up.
+(alarm-wheel) Thread sleeping 300 ticks woke up.
+(alarm-wheel) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* The main thread reads a reader-writer lock.  A higher-priority
+   writer then waits for it to leave and donates its priority to
+   the main thread, so a medium-priority thread created next does
+   not run until the main thread has let the writer in. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread;
+static thread_func medium_thread;
+static struct rwlock rw;
+
+void
+test_rwlock_donate (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 10, writer_thread, NULL);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+
+  thread_create ("medium", PRI_DEFAULT + 5, medium_thread, NULL);
+  msg ("Main releasing read lock.");
+  rw_read_release (&rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  rw_write_acquire (&rw);
+  msg ("Writer acquired.");
+  rw_write_release (&rw);
+  msg ("Writer done.");
+}
+
+static void
+medium_thread (void *aux UNUSED) 
+{
+  msg ("Medium thread ran.");
+}
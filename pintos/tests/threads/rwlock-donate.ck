@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) Main thread should have priority 41.  Actual priority: 41.
+(rwlock-donate) Main releasing read lock.
+(rwlock-donate) Writer acquired.
+(rwlock-donate) Writer done.
+(rwlock-donate) Medium thread ran.
+(rwlock-donate) Main thread should have priority 31.  Actual priority: 31.
+(rwlock-donate) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Tests that a writer waiting on a reader-writer lock holds off
+   readers that arrive after it, and gets the lock as soon as the
+   last earlier reader leaves, ahead of those later readers.  The
+   writer lends its priority to the main thread, so the later
+   reader has to outrank it to get a chance to arrive at all. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread;
+static thread_func reader_thread;
+static struct rwlock rw;
+
+void
+test_rwlock_writer_pref (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  msg ("Main holds read lock; try-write %s.",
+       rw_try_write (&rw) ? "succeeded" : "failed");
+
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread, NULL);
+  msg ("Main back; try-read %s.",
+       rw_try_read (&rw) ? "succeeded" : "failed");
+  thread_create ("reader", PRI_DEFAULT + 3, reader_thread, NULL);
+
+  msg ("Main releasing read lock.");
+  rw_read_release (&rw);
+  msg ("Main done.");
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  msg ("Writer waiting.");
+  rw_write_acquire (&rw);
+  msg ("Writer acquired.");
+  rw_write_release (&rw);
+  msg ("Writer done.");
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  msg ("Reader waiting.");
+  rw_read_acquire (&rw);
+  msg ("Reader acquired.");
+  rw_read_release (&rw);
+  msg ("Reader done.");
+}
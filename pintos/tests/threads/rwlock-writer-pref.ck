@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) Main holds read lock; try-write failed.
+(rwlock-writer-pref) Writer waiting.
+(rwlock-writer-pref) Main back; try-read failed.
+(rwlock-writer-pref) Reader waiting.
+(rwlock-writer-pref) Main releasing read lock.
+(rwlock-writer-pref) Writer acquired.
+(rwlock-writer-pref) Reader acquired.
+(rwlock-writer-pref) Reader done.
+(rwlock-writer-pref) Writer done.
+(rwlock-writer-pref) Main done.
+(rwlock-writer-pref) end
+EOF
+pass;
@@ -0,0 +1,113 @@
+/* Times many reads of a small shared structure under a lock, a
+   sequence lock, and RCU.  The two lock-free read paths should
+   be no slower than taking the lock. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITERATIONS 1000000
+
+/* The shared structure.  A and B are always equal. */
+struct pair
+  {
+    int64_t a, b;
+  };
+
+static struct pair data;
+static struct lock lock;
+static struct seqlock seq;
+static struct pair *rcu_data;
+
+static int64_t time_lock (void);
+static int64_t time_seqlock (void);
+static int64_t time_rcu (void);
+
+void
+test_sync_read_bench (void) 
+{
+  struct pair *old;
+
+  data.a = data.b = 1;
+  lock_init (&lock);
+  seq_init (&seq);
+  rcu_data = malloc (sizeof *rcu_data);
+  ASSERT (rcu_data != NULL);
+  *rcu_data = data;
+
+  msg ("lock: %"PRId64" ticks.", time_lock ());
+  msg ("seqlock: %"PRId64" ticks.", time_seqlock ());
+  msg ("rcu: %"PRId64" ticks.", time_rcu ());
+
+  /* Retire the RCU copy the way an updater would. */
+  old = rcu_data;
+  rcu_assign_pointer (rcu_data, NULL);
+  synchronize_rcu ();
+  free (old);
+}
+
+/* Returns ticks taken by ITERATIONS reads under LOCK. */
+static int64_t
+time_lock (void) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      struct pair p;
+
+      lock_acquire (&lock);
+      p = data;
+      lock_release (&lock);
+      ASSERT (p.a == p.b);
+    }
+  return timer_elapsed (start);
+}
+
+/* Returns ticks taken by ITERATIONS reads under SEQ. */
+static int64_t
+time_seqlock (void) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      struct pair p;
+      unsigned s;
+
+      do
+        {
+          s = seq_read_begin (&seq);
+          p = data;
+        }
+      while (seq_read_retry (&seq, s));
+      ASSERT (p.a == p.b);
+    }
+  return timer_elapsed (start);
+}
+
+/* Returns ticks taken by ITERATIONS reads of RCU_DATA. */
+static int64_t
+time_rcu (void) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      struct pair p;
+
+      rcu_read_lock ();
+      p = *rcu_dereference (rcu_data);
+      rcu_read_unlock ();
+      ASSERT (p.a == p.b);
+    }
+  return timer_elapsed (start);
+}
@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# Get timings.
+local ($_);
+my (%ticks);
+foreach (@output) {
+    my ($what, $t) = /^\(sync-read-bench\) (\w+): (\d+) ticks\.$/
+      or next;
+    $ticks{$what} = $t;
+}
+
+foreach my $what (qw (lock seqlock rcu)) {
+    fail "No timing reported for $what reads.\n"
+      if !defined $ticks{$what};
+}
+
+# Allow one tick of slack for where the timer happens to fire.
+foreach my $what (qw (seqlock rcu)) {
+    fail "$what reads took $ticks{$what} ticks, "
+      . "but lock reads took only $ticks{lock}.\n"
+      if $ticks{$what} > $ticks{lock} + 1;
+}
+pass;
@@ -0,0 +1,50 @@
+/* Forks a process whose memory does not fit in RAM alongside its
+   child's, so frames still shared copy-on-write get evicted and
+   faulted back in.  Each side must keep seeing its own data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (8 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+static void
+check_pages (char xor)
+{
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (big_chunk[i * PAGE_SIZE] != (char) (i ^ xor))
+			fail ("page %zu is inconsistent", i);
+}
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		big_chunk[i * PAGE_SIZE] = (char) i;
+
+	child = fork ("child");
+	if (child == 0) {
+		check_pages (0);
+		msg ("child sees parent's data");
+
+		for (i = 0; i < PAGE_COUNT; i++)
+			big_chunk[i * PAGE_SIZE] = (char) (i ^ 0x5a);
+		check_pages (0x5a);
+		msg ("child sees its own data");
+		return;
+	}
+
+	CHECK (wait (child) == 0, "wait for child");
+	check_pages (0);
+	msg ("parent's data unchanged");
+}
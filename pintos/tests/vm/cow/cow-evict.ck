@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-evict) begin
+(cow-evict) child sees parent's data
+(cow-evict) child sees its own data
+(cow-evict) end
+(cow-evict) wait for child
+(cow-evict) parent's data unchanged
+(cow-evict) end
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Checks that writes to a copy-on-write page after fork stay in
+   the process that made them, whether the write is a user store or
+   a kernel copy made by read() on the child's behalf. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/sample.inc"
+
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_SIZE * 2];
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+	int fd;
+
+	memset (buf, 'p', sizeof buf);
+
+	child = fork ("child");
+	if (child == 0) {
+		CHECK (buf[0] == 'p' && buf[sizeof buf - 1] == 'p',
+		       "child sees parent's data");
+
+		buf[0] = 'c';
+		CHECK (buf[0] == 'c', "store into shared page");
+
+		CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+		CHECK (read (fd, buf + PAGE_SIZE, sizeof sample - 1)
+		       == (int) sizeof sample - 1, "read into shared page");
+		close (fd);
+		CHECK (memcmp (buf + PAGE_SIZE, sample, sizeof sample - 1) == 0,
+		       "child sees file data");
+		return;
+	}
+
+	CHECK (wait (child) == 0, "wait for child");
+	for (i = 0; i < sizeof buf; i++)
+		if (buf[i] != 'p')
+			fail ("parent's byte %zu changed to '%c'", i, buf[i]);
+	msg ("parent's data unchanged");
+}
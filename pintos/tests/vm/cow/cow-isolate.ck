@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-isolate) begin
+(cow-isolate) child sees parent's data
+(cow-isolate) store into shared page
+(cow-isolate) open "sample.txt"
+(cow-isolate) read into shared page
+(cow-isolate) child sees file data
+(cow-isolate) end
+(cow-isolate) wait for child
+(cow-isolate) parent's data unchanged
+(cow-isolate) end
+EOF
+pass;
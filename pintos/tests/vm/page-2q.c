@@ -0,0 +1,84 @@
+/* Runs under the 2q replacement policy.  Keeps a small hot set busy
+   while a long cold region streams past it, then sweeps one more
+   cold stretch without touching the hot set at all.  Under 2q the
+   cold pages only cycle through A1in, so the hot set must still be
+   resident afterward: touching it again may cost only a few swap
+   reads. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define HOT_SIZE (1 * ONE_MB)
+#define COLD_SIZE (24 * ONE_MB)
+#define HOT_PAGES (HOT_SIZE / PAGE_SIZE)
+#define STEP_PAGES (ONE_MB / PAGE_SIZE)
+#define ROUNDS 16
+#define SECTORS_PER_PAGE (PAGE_SIZE / 512)
+
+static char hot[HOT_SIZE];
+static char cold[COLD_SIZE];
+
+/* Returns the number of sectors read from the swap disk, hd1:1. */
+static inline long long
+get_swap_disk_read_cnt (void) {
+	long long read_cnt;
+	asm volatile ("movq $1, %rdx");
+	asm volatile ("movq $1, %rcx");
+	asm volatile ("int $0x43");
+	asm volatile ("\t movq %%rax, %0": "=r" (read_cnt));
+	return read_cnt;
+}
+
+static void
+touch_hot (void)
+{
+	size_t i;
+
+	for (i = 0; i < HOT_PAGES; i++)
+		hot[i * PAGE_SIZE] = (char) i;
+}
+
+static void
+touch_cold (size_t first, size_t cnt)
+{
+	size_t i;
+
+	for (i = first; i < first + cnt; i++)
+		cold[i * PAGE_SIZE] = (char) (i + 1);
+}
+
+void
+test_main (void)
+{
+	long long before, after;
+	size_t i;
+	int round;
+
+	for (round = 0; round < ROUNDS; round++) {
+		touch_hot ();
+		touch_cold (round * STEP_PAGES, STEP_PAGES);
+	}
+	msg ("stream cold pages past the hot set");
+
+	touch_hot ();
+	touch_cold (ROUNDS * STEP_PAGES, COLD_SIZE / PAGE_SIZE - ROUNDS * STEP_PAGES);
+	msg ("sweep cold pages once");
+
+	before = get_swap_disk_read_cnt ();
+	touch_hot ();
+	after = get_swap_disk_read_cnt ();
+	CHECK (after - before < HOT_PAGES * SECTORS_PER_PAGE / 4,
+	       "hot set survived the sweep");
+
+	for (i = 0; i < HOT_PAGES; i++)
+		if (hot[i * PAGE_SIZE] != (char) i)
+			fail ("hot page %zu is inconsistent", i);
+	for (i = 0; i < COLD_SIZE / PAGE_SIZE; i++)
+		if (cold[i * PAGE_SIZE] != (char) (i + 1))
+			fail ("cold page %zu is inconsistent", i);
+	msg ("check consistency");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-2q) begin
+(page-2q) stream cold pages past the hot set
+(page-2q) sweep cold pages once
+(page-2q) hot set survived the sweep
+(page-2q) check consistency
+(page-2q) end
+EOF
+
+our ($test);
+my ($stats) = grep (/^VM: /, read_text_file ("$test.output"));
+fail "No VM statistics in output.\n" if !defined $stats;
+fail "Kernel did not run the 2q policy.\n" if $stats !~ /\(2q\)$/;
+my ($ghost_hits) = $stats =~ /(\d+) ghost hits/;
+fail "The hot set never moved to Am (no ghost hits).\n"
+  if !defined $ghost_hits || $ghost_hits == 0;
+pass;
@@ -0,0 +1,45 @@
+/* Runs several processes at once whose combined memory exceeds
+   RAM, so the evictor keeps picking frames that belong to some
+   other process.  Each child stamps every page with its own tag and
+   must read back exactly its own tags. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (4 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+static int
+stamp_and_check (int tag)
+{
+  size_t i;
+  int pass;
+
+  for (pass = 0; pass < 2; pass++)
+    for (i = 0; i < PAGE_COUNT; i++)
+      big_chunk[i * PAGE_SIZE] = (char) (i * CHILD_CNT + tag);
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunk[i * PAGE_SIZE] != (char) (i * CHILD_CNT + tag))
+      return -1;
+  return tag;
+}
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    children[i] = fork ("child");
+    if (children[i] == 0)
+      exit (stamp_and_check (i));
+  }
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (children[i]) == i, "wait for child %d", i);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-owners) begin
+(page-owners) wait for child 0
+(page-owners) wait for child 1
+(page-owners) wait for child 2
+(page-owners) wait for child 3
+(page-owners) end
+EOF
+pass;
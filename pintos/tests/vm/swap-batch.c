@@ -0,0 +1,34 @@
+/* Fills more anonymous memory than fits in RAM, one distinct byte
+   value per page, then reads every sector of every page back.
+   Each page goes to and from swap as a single multi-sector disk
+   command, which the check script verifies from the swap disk's
+   shutdown statistics. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SECTOR_SIZE 512
+#define CHUNK_SIZE (16 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+	size_t i, ofs;
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		memset (big_chunk + i * PAGE_SIZE, (char) i, PAGE_SIZE);
+	msg ("fill pages");
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		for (ofs = 0; ofs < PAGE_SIZE; ofs += SECTOR_SIZE)
+			if (big_chunk[i * PAGE_SIZE + ofs] != (char) i
+			    || big_chunk[i * PAGE_SIZE + ofs + SECTOR_SIZE - 1] != (char) i)
+				fail ("page %zu is inconsistent at offset %zu", i, ofs);
+	msg ("check every sector");
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-batch) begin
+(swap-batch) fill pages
+(swap-batch) check every sector
+(swap-batch) end
+EOF
+
+# The swap disk is hd1:1.  Each page is eight sectors, so batched
+# swap I/O issues one command per eight sectors.  Allow twice that
+# for anything else that touches the disk.
+our ($test);
+my ($reads, $writes, $cmds);
+foreach (read_text_file ("$test.output")) {
+    ($reads, $writes, $cmds) = /^hd1:1: (\d+) reads, (\d+) writes, (\d+) commands$/
+      and last;
+}
+fail "No statistics for swap disk hd1:1.\n" if !defined $cmds;
+fail "Nothing was written to swap.\n" if $writes == 0;
+fail "$cmds commands moved " . ($reads + $writes) . " sectors of swap.\n"
+  if $cmds > ($reads + $writes) / 4;
+pass;
@@ -0,0 +1,42 @@
+/* Boots with -vm-wm=16,48 so a background daemon pages out frames
+   whenever fewer than 16 are free.  Several children fill more memory
+   than fits in RAM at once; each must read back its own data. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 3
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (4 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+static int
+fill_and_check (int tag)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunk[i * PAGE_SIZE] = (char) (i + tag);
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunk[i * PAGE_SIZE] != (char) (i + tag))
+      return -1;
+  return tag;
+}
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    children[i] = fork ("child");
+    if (children[i] == 0)
+      exit (fill_and_check (i));
+  }
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (children[i]) == i, "wait for child %d", i);
+}
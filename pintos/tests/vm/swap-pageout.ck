@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-pageout) begin
+(swap-pageout) wait for child 0
+(swap-pageout) wait for child 1
+(swap-pageout) wait for child 2
+(swap-pageout) end
+EOF
+
+our ($test);
+my ($stats) = grep (/^VM: /, read_text_file ("$test.output"));
+fail "No VM statistics in output.\n" if !defined $stats;
+my ($background) = $stats =~ /\((\d+) in background\)/;
+fail "The pageout daemon never evicted a frame.\n"
+  if !defined $background || $background == 0;
+pass;
@@ -0,0 +1,42 @@
+/* Boots with -swap-ra=8.  Swaps out a run of pages, frees plenty of
+   frames by letting a child fill and then drop its own memory, and
+   reads the run back in order.  Readahead may then bring several
+   neighbouring slots in with each fault; every page must still hold
+   its own data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (8 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char parent_chunk[CHUNK_SIZE];
+static char child_chunk[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		memset (parent_chunk + i * PAGE_SIZE, (char) i, PAGE_SIZE);
+	msg ("fill parent's pages");
+
+	child = fork ("child");
+	if (child == 0) {
+		for (i = 0; i < PAGE_COUNT; i++)
+			child_chunk[i * PAGE_SIZE] = (char) i;
+		exit (0);
+	}
+	CHECK (wait (child) == 0, "wait for child");
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (parent_chunk[i * PAGE_SIZE] != (char) i
+		    || parent_chunk[(i + 1) * PAGE_SIZE - 1] != (char) i)
+			fail ("page %zu is inconsistent", i);
+	msg ("read parent's pages back");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-ra) begin
+(swap-ra) fill parent's pages
+(swap-ra) wait for child
+(swap-ra) read parent's pages back
+(swap-ra) end
+EOF
+
+our ($test);
+my ($stats) = grep (/^VM: /, read_text_file ("$test.output"));
+fail "No VM statistics in output.\n" if !defined $stats;
+my ($readahead) = $stats =~ /(\d+) readahead/;
+fail "No page was read ahead from swap.\n"
+  if !defined $readahead || $readahead == 0;
+pass;
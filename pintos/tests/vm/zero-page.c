@@ -0,0 +1,53 @@
+/* Reads untouched pages of a zero-filled array.  They must all read
+   as zero through one shared physical page.  Writing one of them must
+   give that page a frame of its own and leave the rest alone. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 16
+
+/* The first and last pages may share a page with other data, so only
+   the pages in between are checked. */
+static char zeros[PAGE_SIZE * PAGE_COUNT];
+
+static bool
+page_is_zero (const char *page)
+{
+	size_t i;
+
+	for (i = 0; i < PAGE_SIZE; i++)
+		if (page[i] != 0)
+			return false;
+	return true;
+}
+
+void
+test_main (void)
+{
+	void *zero_pa;
+	size_t i;
+
+	for (i = 1; i < PAGE_COUNT - 1; i++)
+		if (!page_is_zero (zeros + i * PAGE_SIZE))
+			fail ("page %zu is not zero", i);
+	msg ("untouched pages read as zero");
+
+	zero_pa = get_phys_addr (zeros + PAGE_SIZE);
+	CHECK (zero_pa != NULL, "untouched page is mapped");
+	for (i = 2; i < PAGE_COUNT - 1; i++)
+		if (get_phys_addr (zeros + i * PAGE_SIZE) != zero_pa)
+			fail ("page %zu does not share the zero page", i);
+	msg ("untouched pages share one physical page");
+
+	zeros[5 * PAGE_SIZE] = 'x';
+	CHECK (get_phys_addr (zeros + 5 * PAGE_SIZE) != zero_pa,
+	       "written page has its own frame");
+	CHECK (zeros[5 * PAGE_SIZE] == 'x', "written page keeps its data");
+	CHECK (get_phys_addr (zeros + 6 * PAGE_SIZE) == zero_pa
+	       && page_is_zero (zeros + 6 * PAGE_SIZE),
+	       "neighbouring page still shares the zero page");
+}
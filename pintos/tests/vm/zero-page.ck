@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-page) begin
+(zero-page) untouched pages read as zero
+(zero-page) untouched page is mapped
+(zero-page) untouched pages share one physical page
+(zero-page) written page has its own frame
+(zero-page) written page keeps its data
+(zero-page) neighbouring page still shares the zero page
+(zero-page) end
+EOF
+pass;
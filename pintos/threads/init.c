@@ -13,6 +13,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -167,6 +168,11 @@ paging_init(uint64_t mem_end)
 
 	// reload cr3
 	pml4_activate(0);
+
+	/* Make kernel writes to read-only user pages fault like user
+	   writes do, so copies into a copy-on-write or zero page made
+	   on behalf of a system call are caught too. */
+	lcr0(rcr0() | CR0_WP);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -227,11 +233,40 @@ parse_options(char **argv)
 			random_init(atoi(value));
 		else if (!strcmp(name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp(name, "-tickless"))
+			timer_tickless = true;
 #ifdef USERPROG
 		else if (!strcmp(name, "-ul"))
 			user_page_limit = atoi(value);
 		else if (!strcmp(name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp(name, "-vm-policy"))
+		{
+			if (value != NULL && !strcmp(value, "clock"))
+				vm_policy = VM_POLICY_CLOCK;
+			else if (value != NULL && !strcmp(value, "2q"))
+				vm_policy = VM_POLICY_2Q;
+			else
+				PANIC("unknown page replacement policy `%s'", value);
+		}
+		else if (!strcmp(name, "-swap-ra"))
+		{
+			if (value == NULL)
+				PANIC("-swap-ra requires COUNT");
+			swap_readahead = atoi(value);
+		}
+		else if (!strcmp(name, "-vm-wm"))
+		{
+			char *high;
+
+			if (value == NULL)
+				PANIC("-vm-wm requires LOW,HIGH");
+			high = strchr(value, ',');
+			vm_free_low = atoi(value);
+			vm_free_high = high != NULL ? (size_t)atoi(high + 1) : SIZE_MAX;
+		}
 #endif
 		else
 			PANIC("unknown option `%s' (use -h for help)", name);
@@ -280,6 +315,7 @@ run_actions(char **argv)
 		{"run", 2, run_task},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
+		{"frag", 1, fsutil_frag},
 		{"cat", 2, fsutil_cat},
 		{"rm", 2, fsutil_rm},
 		{"put", 2, fsutil_put},
@@ -327,6 +363,7 @@ usage(void)
 #endif
 #ifdef FILESYS
 		   "  ls                 List files in the root directory.\n"
+		   "  frag               Report fragmentation of root directory files.\n"
 		   "  cat FILE           Print FILE to the console.\n"
 		   "  rm FILE            Delete FILE.\n"
 		   "Use these actions indirectly via `pintos' -g and -p options:\n"
@@ -339,8 +376,15 @@ usage(void)
 		   "  -f                 Format file system disk during startup.\n"
 		   "  -rs=SEED           Set random number seed to SEED.\n"
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+		   "  -tickless          Interrupt only at timer deadlines, not every tick.\n"
 #ifdef USERPROG
 		   "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+		   "  -vm-policy=POLICY  Page replacement policy: clock (default) or 2q.\n"
+		   "  -swap-ra=COUNT     Read up to COUNT following swap slots on swap-in.\n"
+		   "  -vm-wm=LOW,HIGH    Page out in the background below LOW free frames\n"
+		   "                     until HIGH are free.  LOW of 0 turns it off.\n"
 #endif
 	);
 	power_off();
@@ -376,4 +420,7 @@ print_stats(void)
 #ifdef USERPROG
 	exception_print_stats();
 #endif
+#ifdef VM
+	vm_print_stats();
+#endif
 }
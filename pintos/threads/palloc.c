@@ -328,6 +328,35 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of page slots in the user pool, including the
+   slots that were marked unusable by populate_pools(). */
+size_t
+palloc_user_page_cnt (void) {
+	return bitmap_size (user_pool.used_map);
+}
+
+/* Returns the number of free pages in the user pool. */
+size_t
+palloc_user_free_cnt (void) {
+	size_t cnt;
+
+	lock_acquire (&user_pool.lock);
+	cnt = bitmap_count (user_pool.used_map, 0,
+			bitmap_size (user_pool.used_map), false);
+	lock_release (&user_pool.lock);
+	return cnt;
+}
+
+/* Returns the index of user page KVA inside the user pool, or
+   SIZE_MAX if KVA does not belong to it.  Frame tables can use it
+   to map a kva to a slot in O(1). */
+size_t
+palloc_user_page_idx (const void *kva) {
+	if (!page_from_pool (&user_pool, (void *) kva))
+		return SIZE_MAX;
+	return pg_no (kva) - pg_no (user_pool.base);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
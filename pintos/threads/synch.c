@@ -63,6 +63,7 @@ void sema_down(struct semaphore *sema)
 
 	ASSERT(sema != NULL);
 	ASSERT(!intr_context());
+	ASSERT(thread_current()->rcu_nesting == 0);
 
 	old_level = intr_disable();
 	while (sema->value == 0)
@@ -113,6 +114,17 @@ void sema_up(struct semaphore *sema)
 	sema->value++;
 	if (!list_empty(&sema->waiters))
 	{
+		/* Under the MLFQS a sleeper's priority goes stale while
+		   it misses the once-a-second decays, so bring each up to
+		   date before choosing. */
+		if (thread_mlfqs)
+		{
+			struct list_elem *e;
+
+			for (e = list_begin(&sema->waiters); e != list_end(&sema->waiters);
+				 e = list_next(e))
+				thread_mlfqs_refresh(list_entry(e, struct thread, elem));
+		}
 		list_sort(&sema->waiters, higher_priority, NULL);
 		thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
 	}
@@ -193,7 +205,7 @@ void lock_acquire(struct lock *lock)
 	ASSERT(!lock_held_by_current_thread(lock));
 
 	struct thread *cur = thread_current();
-	if (lock->holder)
+	if (lock->holder && !thread_mlfqs)
 	{
 		cur->waiting_lock = lock;
 		donate(lock->holder, lock);
@@ -233,7 +245,8 @@ void lock_release(struct lock *lock)
 	ASSERT(lock != NULL);
 	ASSERT(lock_held_by_current_thread(lock));
 	lock->holder = NULL;
-	thread_restore_by_lock(lock); // lock에 대한 도네이션 원복
+	if (!thread_mlfqs)
+		thread_restore_by_lock(lock); // lock에 대한 도네이션 원복
 	sema_up(&lock->semaphore);
 }
 
@@ -252,6 +265,7 @@ struct semaphore_elem
 {
 	struct list_elem elem;		/* List element. */
 	struct semaphore semaphore; /* This semaphore. */
+	struct thread *thread;		/* The waiting thread. */
 	int64_t priority;
 };
 
@@ -296,6 +310,7 @@ static bool higher_sema_priority(const struct list_elem *ne, const struct list_e
 void cond_wait(struct condition *cond, struct lock *lock)
 {
 	struct semaphore_elem waiter;
+	waiter.thread = thread_current();
 	waiter.priority = thread_get_priority();
 
 	ASSERT(cond != NULL);
@@ -325,7 +340,27 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
 	ASSERT(lock_held_by_current_thread(lock));
 
 	if (!list_empty(&cond->waiters))
+	{
+		/* As in sema_up(), MLFQS waiters' priorities are brought
+		   up to date before choosing one. */
+		if (thread_mlfqs)
+		{
+			enum intr_level old_level = intr_disable();
+			struct list_elem *e;
+
+			for (e = list_begin(&cond->waiters); e != list_end(&cond->waiters);
+				 e = list_next(e))
+			{
+				struct semaphore_elem *w = list_entry(e, struct semaphore_elem, elem);
+
+				thread_mlfqs_refresh(w->thread);
+				w->priority = w->thread->priority;
+			}
+			list_sort(&cond->waiters, higher_sema_priority, NULL);
+			intr_set_level(old_level);
+		}
 		sema_up(&list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)->semaphore);
+	}
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -342,3 +377,262 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 	while (!list_empty(&cond->waiters))
 		cond_signal(cond, lock);
 }
+
+/* Initializes RW as an unheld reader-writer lock. */
+void rw_init(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	lock_init(&rw->writer);
+	sema_init(&rw->drained, 0);
+	rw->readers = 0;
+	rw->draining = false;
+	list_init(&rw->holders);
+}
+
+/* Records that the current thread reads RW, so a writer waiting
+   on RW can donate to it.  A thread may read at most RW_HOLD_MAX
+   locks at once; a reader a writer could not donate to would bring
+   back the priority inversion donation exists to prevent.
+   Interrupts must be off. */
+static void rw_hold_add(struct rwlock *rw)
+{
+	struct thread *cur = thread_current();
+	struct rw_hold *h;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(cur->rw_hold_cnt < RW_HOLD_MAX);
+
+	h = &cur->rw_holds[cur->rw_hold_cnt++];
+	h->rw = rw;
+	h->thread = cur;
+	list_push_back(&rw->holders, &h->elem);
+}
+
+/* Undoes rw_hold_add(RW), moving the last entry into the freed
+   slot.  Interrupts must be off. */
+static void rw_hold_remove(struct rwlock *rw)
+{
+	struct thread *cur = thread_current();
+	struct rw_hold *last;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (i = 0; i < cur->rw_hold_cnt; i++)
+		if (cur->rw_holds[i].rw == rw)
+			break;
+	ASSERT(i < cur->rw_hold_cnt);
+	list_remove(&cur->rw_holds[i].elem);
+	last = &cur->rw_holds[--cur->rw_hold_cnt];
+	if (&cur->rw_holds[i] != last)
+	{
+		list_remove(&last->elem);
+		cur->rw_holds[i] = *last;
+		list_push_back(&last->rw->holders, &cur->rw_holds[i].elem);
+	}
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   waits for it.  Passing through WRITER donates priority to that
+   writer.  A reader must not acquire RW again before releasing
+   it, since a writer arriving in between would deadlock. */
+void rw_read_acquire(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rw->writer);
+	old_level = intr_disable();
+	rw->readers++;
+	rw_hold_add(rw);
+	intr_set_level(old_level);
+	lock_release(&rw->writer);
+}
+
+/* Tries to acquire RW for reading without sleeping.  Returns
+   true if successful, false if a writer holds or waits for it. */
+bool rw_try_read(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+
+	if (!lock_try_acquire(&rw->writer))
+		return false;
+	old_level = intr_disable();
+	rw->readers++;
+	rw_hold_add(rw);
+	intr_set_level(old_level);
+	lock_release(&rw->writer);
+	return true;
+}
+
+/* Releases RW, which the current thread holds for reading.  The
+   last reader out lets a waiting writer in. */
+void rw_read_release(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->readers > 0);
+
+	old_level = intr_disable();
+	rw_hold_remove(rw);
+	if (--rw->readers == 0 && rw->draining)
+	{
+		rw->draining = false;
+		sema_up(&rw->drained);
+	}
+	intr_set_level(old_level);
+	if (!thread_mlfqs)
+		thread_restore_by_rw();
+}
+
+/* Acquires RW for writing, sleeping until no other writer holds
+   it and every reader has left.  New readers are held off from
+   the moment this is called, and the readers still in get this
+   thread's priority while it waits. */
+void rw_write_acquire(struct rwlock *rw)
+{
+	enum intr_level old_level;
+	bool wait;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rw->writer);
+	old_level = intr_disable();
+	wait = rw->draining = rw->readers > 0;
+	intr_set_level(old_level);
+	if (wait)
+	{
+		/* Like lock_acquire(), lend our priority to the readers
+		   we wait on until the last of them leaves. */
+		if (!thread_mlfqs)
+		{
+			thread_current()->waiting_rw = rw;
+			donate_readers(rw);
+		}
+		sema_down(&rw->drained);
+		thread_current()->waiting_rw = NULL;
+	}
+}
+
+/* Tries to acquire RW for writing without sleeping.  Returns
+   true if successful, false if anyone holds it. */
+bool rw_try_write(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	if (!lock_try_acquire(&rw->writer))
+		return false;
+	if (rw->readers > 0)
+	{
+		lock_release(&rw->writer);
+		return false;
+	}
+	return true;
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void rw_write_release(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+	ASSERT(rw->readers == 0);
+
+	lock_release(&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool rw_write_held_by_current_thread(const struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	return lock_held_by_current_thread(&rw->writer);
+}
+
+/* Initializes SL. */
+void seq_init(struct seqlock *sl)
+{
+	ASSERT(sl != NULL);
+
+	sl->seq = 0;
+}
+
+/* Begins a read of the data SL protects.  Returns a value to pass
+   to seq_read_retry() once the data has been copied out. */
+unsigned seq_read_begin(const struct seqlock *sl)
+{
+	unsigned seq = sl->seq;
+
+	barrier();
+	return seq & ~1u;
+}
+
+/* Returns true if the data SL protects changed since START was
+   returned by seq_read_begin(), in which case the copy just made
+   may be torn and the read must be done again. */
+bool seq_read_retry(const struct seqlock *sl, unsigned start)
+{
+	barrier();
+	return sl->seq != start;
+}
+
+/* Begins a write of the data SL protects.  Interrupts stay off
+   until seq_write_end(). */
+void seq_write_begin(struct seqlock *sl)
+{
+	enum intr_level old_level = intr_disable();
+
+	sl->old_level = old_level;
+	sl->seq++;
+	barrier();
+}
+
+/* Ends a write begun by seq_write_begin(). */
+void seq_write_end(struct seqlock *sl)
+{
+	barrier();
+	sl->seq++;
+	intr_set_level(sl->old_level);
+}
+
+/* Enters an RCU read-side critical section.  Sections nest. */
+void rcu_read_lock(void)
+{
+	thread_current()->rcu_nesting++;
+	barrier();
+}
+
+/* Leaves an RCU read-side critical section, taking any yield put
+   off while in it. */
+void rcu_read_unlock(void)
+{
+	struct thread *t = thread_current();
+
+	ASSERT(t->rcu_nesting > 0);
+
+	barrier();
+	if (--t->rcu_nesting == 0 && t->rcu_yield && !intr_context())
+	{
+		t->rcu_yield = false;
+		thread_yield();
+	}
+}
+
+/* Waits until every read-side critical section in progress has
+   ended, so that data unpublished before the call may be freed.
+   Readers are never switched out mid-section and an interrupt
+   handler runs to completion before the interrupted thread
+   resumes, so once the caller is running outside a section of
+   its own, no reader can still hold an old pointer. */
+void synchronize_rcu(void)
+{
+	ASSERT(!intr_context());
+	ASSERT(thread_current()->rcu_nesting == 0);
+
+	barrier();
+}
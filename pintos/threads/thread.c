@@ -10,6 +10,7 @@
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "list.h"
 #ifdef USERPROG
@@ -17,6 +18,7 @@
 #endif
 
 #define MAX(a, b) ((a) > (b) ? a : b)
+#define MIN(a, b) ((a) < (b) ? a : b)
 /* Random value for struct thread's `magic' member.
    Used to detect stack overflow.  See the big comment at the top
    of thread.h for details. */
@@ -26,12 +28,15 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-// List of processes in THREAD_BLOCKED state,
-static struct list sleep_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running: one FIFO per priority,
+   and a bitmap with bit P set if ready_queues[P] is non-empty. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static size_t ready_cnt;	/* Threads in all ready_queues. */
+#if PRI_MAX - PRI_MIN >= 64
+#error ready_mask needs one bit per priority
+#endif
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -60,6 +65,16 @@ static bool schedule_enable = false; /* thread_start가 끝나 스케줄이 가
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* MLFQS state.  Once a second the load average is updated and
+   every thread's recent_cpu decays by a factor that depends on
+   it.  Only the running and ready threads are decayed then; a
+   blocked thread catches up on the seconds it missed, from
+   load_history, when it is unblocked. */
+#define LOAD_HISTORY 64				 /* Seconds of load average kept. */
+static fixed_t load_avg;			 /* System load average. */
+static fixed_t load_history[LOAD_HISTORY]; /* load_avg after each second. */
+static int64_t decay_seconds;		 /* Once-a-second passes so far. */
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -69,6 +84,14 @@ static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
 static void thread_refresh_priority(struct thread *t, bool in_chain);
+static void ready_push(struct thread *);
+static void ready_remove(struct thread *);
+static int ready_max_priority(void);
+static void mlfqs_tick(struct thread *, int64_t tick);
+static bool recent_cpu_catch_up(struct thread *);
+static int mlfqs_priority(const struct thread *);
+static int64_t next_deadline(struct thread *, int64_t now);
+static void thread_awake(void *t);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -112,8 +135,10 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
-	list_init(&sleep_list);
+	for (int p = PRI_MIN; p <= PRI_MAX; p++)
+		list_init(&ready_queues[p]);
+	ready_mask = 0;
+	ready_cnt = 0;
 	list_init(&destruction_req);
 
 	/* Set up a thread structure for the running thread. */
@@ -143,9 +168,10 @@ void thread_start(void)
 	// schedule_enable = true; // sema 풀린 후 플래그 설정 (구버전)
 }
 
-/* Called by the timer interrupt handler at each timer tick.
+/* Called by the timer interrupt handler for timer tick TICK,
+   once for each tick even when one interrupt covers several.
    Thus, this function runs in an external interrupt context. */
-void thread_tick(void)
+void thread_tick(int64_t tick)
 {
 	struct thread *t = thread_current();
 
@@ -159,11 +185,157 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+		mlfqs_tick(t, tick);
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return();
 }
 
+/* Returns the tick by which the timer must next interrupt while
+   RUNNING runs, as of tick NOW: when the timer wheel next has work,
+   or when RUNNING's time slice ends.  The MLFQS also needs the next
+   fourth tick and second, when priorities are recomputed, but only
+   while a thread runs: thread_tick() is called for every tick an
+   interrupt covers, so an idle CPU catches up when it next wakes. */
+static int64_t
+next_deadline(struct thread *running, int64_t now)
+{
+	int64_t deadline = timer_next_event();
+
+	if (running == idle_thread)
+		return deadline;
+	deadline = MIN(deadline, now + TIME_SLICE - (int64_t)thread_ticks);
+	if (thread_mlfqs)
+	{
+		deadline = MIN(deadline, (now / 4 + 1) * 4);
+		deadline = MIN(deadline, (now / TIMER_FREQ + 1) * TIMER_FREQ);
+	}
+	return deadline;
+}
+
+/* Returns the tick by which the timer must next interrupt, as of
+   tick NOW.  For tickless mode. */
+int64_t thread_next_deadline(int64_t now)
+{
+	return next_deadline(thread_current(), now);
+}
+
+/* Charges tick TICK to running thread T and, on schedule, updates
+   the load average, recent_cpu and priorities.  T's priority is
+   recomputed every fourth tick; other threads' only change at the
+   once-a-second pass, since only T's recent_cpu grows between
+   passes. */
+static void
+mlfqs_tick(struct thread *t, int64_t tick)
+{
+	if (t != idle_thread)
+		t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+
+	if (tick % TIMER_FREQ == 0)
+	{
+		struct list moved;
+
+		load_avg = fp_div_int(fp_add_int(fp_mul_int(load_avg, 59),
+										 ready_cnt + (t != idle_thread)),
+							  60);
+		load_history[decay_seconds % LOAD_HISTORY] = load_avg;
+		decay_seconds++;
+
+		/* Decay every ready thread and requeue it at its new
+		   priority. */
+		list_init(&moved);
+		for (int p = PRI_MAX; p >= PRI_MIN; p--)
+			while (!list_empty(&ready_queues[p]))
+				list_push_back(&moved, list_pop_front(&ready_queues[p]));
+		ready_mask = 0;
+		ready_cnt = 0;
+		while (!list_empty(&moved))
+		{
+			struct thread *r = list_entry(list_pop_front(&moved), struct thread, elem);
+
+			recent_cpu_catch_up(r);
+			r->base_priority = r->priority = mlfqs_priority(r);
+			ready_push(r);
+		}
+		if (t != idle_thread)
+			recent_cpu_catch_up(t);
+	}
+
+	if (tick % 4 == 0 && t != idle_thread)
+	{
+		t->base_priority = t->priority = mlfqs_priority(t);
+		thread_preemption();
+	}
+}
+
+/* Returns the factor by which recent_cpu decays in a second that
+   ends with load average LOAD. */
+static fixed_t
+decay_factor(fixed_t load)
+{
+	fixed_t twice = fp_mul_int(load, 2);
+
+	return fp_div(twice, fp_add_int(twice, 1));
+}
+
+/* Applies to T's recent_cpu the once-a-second decays it has
+   missed.  Returns true if there were any.  Interrupts must be
+   off. */
+static bool
+recent_cpu_catch_up(struct thread *t)
+{
+	int64_t gap = decay_seconds - t->decay_stamp;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (gap == 0)
+		return false;
+	if (gap > LOAD_HISTORY)
+	{
+		/* Seconds older than load_history are taken to have had
+		   its oldest load average.  Under a fixed decay factor
+		   recent_cpu closes in on nice * (2 * load + 1)
+		   geometrically, so all of them are applied at once. */
+		fixed_t load = load_history[decay_seconds % LOAD_HISTORY];
+		fixed_t limit = fp_mul_int(fp_add_int(fp_mul_int(load, 2), 1), t->nice);
+		fixed_t f = fp_pow(decay_factor(load), gap - LOAD_HISTORY);
+
+		t->recent_cpu = fp_add(limit, fp_mul(f, fp_sub(t->recent_cpu, limit)));
+		gap = LOAD_HISTORY;
+	}
+	for (int64_t s = decay_seconds - gap; s < decay_seconds; s++)
+		t->recent_cpu = fp_add_int(fp_mul(decay_factor(load_history[s % LOAD_HISTORY]),
+										  t->recent_cpu),
+								   t->nice);
+	t->decay_stamp = decay_seconds;
+	return true;
+}
+
+/* Applies to T, which is not running, the recent_cpu decays it
+   has missed and recomputes its priority if there were any.
+   Interrupts must be off. */
+void
+thread_mlfqs_refresh(struct thread *t)
+{
+	ASSERT(thread_mlfqs);
+
+	if (recent_cpu_catch_up(t))
+		t->base_priority = t->priority = mlfqs_priority(t);
+}
+
+/* Returns T's MLFQS priority,
+   PRI_MAX - recent_cpu / 4 - nice * 2, within range. */
+static int
+mlfqs_priority(const struct thread *t)
+{
+	int p = fp_trunc(fp_sub(fp_from_int(PRI_MAX - t->nice * 2),
+							fp_div_int(t->recent_cpu, 4)));
+
+	return p < PRI_MIN ? PRI_MIN : p > PRI_MAX ? PRI_MAX : p;
+}
+
 /* Prints thread statistics. */
 void thread_print_stats(void)
 {
@@ -202,6 +374,18 @@ tid_t thread_create(const char *name, int priority,
 	/* Initialize thread. */
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
+	if (thread_mlfqs && function != idle)
+	{
+		struct thread *parent = thread_current();
+		enum intr_level old_level = intr_disable();
+
+		recent_cpu_catch_up(parent);
+		t->nice = parent->nice;
+		t->recent_cpu = parent->recent_cpu;
+		t->decay_stamp = decay_seconds;
+		t->base_priority = t->priority = mlfqs_priority(t);
+		intr_set_level(old_level);
+	}
 
 	struct child_status *cs = malloc(sizeof(struct child_status));
 	sema_init(&cs->dead, 0);
@@ -249,14 +433,6 @@ struct child_status *find_matched_tid(tid_t tid)
 	return list_entry(item, struct child_status, elem);
 }
 
-// 중단조건
-static bool earlier_wakeup(const struct list_elem *new_elem, const struct list_elem *item, void *aux)
-{
-	int64_t new_wtick = list_entry(new_elem, struct thread, elem)->wakeup_tick;
-	int64_t item_wtick = list_entry(item, struct thread, elem)->wakeup_tick;
-	return new_wtick < item_wtick;
-}
-
 bool higher_priority(const struct list_elem *new_elem, const struct list_elem *item, void *aux)
 {
 	int64_t new_priority = list_entry(new_elem, struct thread, elem)->priority;
@@ -264,19 +440,7 @@ bool higher_priority(const struct list_elem *new_elem, const struct list_elem *i
 	return new_priority > item_priority;
 }
 
-// 깨워야할 쓰레드 깨우기
-void awake_sleep_threads(int64_t now)
-{
-	while (!list_empty(&sleep_list))
-	{
-		struct thread *ft = list_entry(list_front(&sleep_list), struct thread, elem);
-		if (ft->wakeup_tick > now)
-			break;
-		thread_awake(ft);
-	}
-}
-
-// thread sleep (insert sleep_list + thread_block)
+// thread sleep (timer wheel 에 sleep_timer 등록 + thread_block)
 void thread_sleep()
 {
 	struct thread *t = thread_current();
@@ -287,17 +451,18 @@ void thread_sleep()
 	ASSERT(t->status == THREAD_RUNNING);
 
 	enum intr_level old = intr_disable();
-	list_insert_ordered(&sleep_list, &(t->elem), earlier_wakeup, NULL);
+	ktimer_add(&t->sleep_timer, t->wakeup_tick);
 	thread_block();
 	intr_set_level(old);
 }
 
-// awake = remove to sleep_list + unblock
-void thread_awake(struct thread *t)
+// awake = sleep_timer 만료 시 timer interrupt 에서 unblock
+static void thread_awake(void *t_)
 {
+	struct thread *t = t_;
+
 	ASSERT(t->status == THREAD_BLOCKED);
 	ASSERT(intr_get_level() == INTR_OFF);
-	list_remove(&(t->elem));
 	thread_unblock(t);
 }
 
@@ -311,6 +476,7 @@ void thread_block(void)
 {
 	ASSERT(!intr_context());
 	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(thread_current()->rcu_nesting == 0);
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
 }
@@ -328,6 +494,8 @@ void thread_preemption()
 {
 	// ASSERT(schedule_enable);
 
+	if (ready_max_priority() <= thread_get_priority())
+		return;
 	if (intr_context())
 		intr_yield_on_return();
 	else
@@ -342,14 +510,14 @@ void thread_unblock(struct thread *t)
 	ASSERT(t->status == THREAD_BLOCKED);
 
 	old_level = intr_disable();
-	list_insert_ordered(&ready_list, &t->elem, higher_priority, NULL);
+	if (thread_mlfqs)
+		thread_mlfqs_refresh(t);
+	ready_push(t);
 	t->status = THREAD_READY;
 	// 즉시선점
 	// if (schedule_enable &&
-	if (t != idle_thread && t->priority > thread_get_priority())
-	{
+	if (t != idle_thread)
 		thread_preemption();
-	}
 
 	intr_set_level(old_level);
 }
@@ -404,7 +572,9 @@ void thread_exit(void)
 }
 
 /* Yields the CPU.  The current thread is not put to sleep and
-   may be scheduled again immediately at the scheduler's whim. */
+   may be scheduled again immediately at the scheduler's whim.
+   Inside an RCU read-side critical section the yield is put off
+   until the section ends. */
 void thread_yield(void)
 {
 	struct thread *curr = thread_current();
@@ -412,9 +582,15 @@ void thread_yield(void)
 
 	ASSERT(!intr_context());
 
+	if (curr->rcu_nesting > 0)
+	{
+		curr->rcu_yield = true;
+		return;
+	}
+
 	old_level = intr_disable();
 	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, higher_priority, NULL);
+		ready_push(curr);
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
@@ -429,9 +605,22 @@ static bool is_max(const struct list_elem *max, const struct list_elem *v, void
 static void donate_chain(struct thread *thr)
 {
 	struct lock *l = thr->waiting_lock;
+
+	/* A writer draining an rwlock passes its priority on to the
+	   readers, and each of them on along its own chain. */
+	if (thr->waiting_rw != NULL)
+	{
+		donate_readers(thr->waiting_rw);
+		return;
+	}
 	while (l && l->holder)
 	{
 		thread_refresh_priority(l->holder, true);
+		if (l->holder->waiting_rw != NULL)
+		{
+			donate_readers(l->holder->waiting_rw);
+			break;
+		}
 		l = l->holder->waiting_lock;
 	}
 }
@@ -448,7 +637,22 @@ static void thread_refresh_priority(struct thread *thr, bool in_donate)
 								  struct thread, donation_elem)
 						   ->priority;
 	}
-	thr->priority = MAX(thr->base_priority, donation_max);
+	/* A writer draining an rwlock THR reads holds it in WRITER. */
+	for (int i = 0; i < thr->rw_hold_cnt; i++)
+	{
+		struct rwlock *rw = thr->rw_holds[i].rw;
+		if (rw->draining && rw->writer.holder != NULL)
+			donation_max = MAX(donation_max, rw->writer.holder->priority);
+	}
+	/* A ready thread moves to the queue for its new priority. */
+	if (thr->status == THREAD_READY)
+	{
+		ready_remove(thr);
+		thr->priority = MAX(thr->base_priority, donation_max);
+		ready_push(thr);
+	}
+	else
+		thr->priority = MAX(thr->base_priority, donation_max);
 	intr_set_level(old);
 
 	if (!in_donate)
@@ -488,26 +692,46 @@ void thread_restore_by_lock(struct lock *lock)
 	thread_refresh_priority(thread, false);
 }
 
+/* Raises every reader of RW to the priority of the writer
+   waiting for them to leave. */
+void donate_readers(struct rwlock *rw)
+{
+	struct list_elem *e;
+
+	enum intr_level old = intr_disable();
+	for (e = list_begin(&rw->holders); e != list_end(&rw->holders);
+		 e = list_next(e))
+		thread_refresh_priority(list_entry(e, struct rw_hold, elem)->thread,
+								false);
+	intr_set_level(old);
+}
+
+/* Drops what the current thread had from writers waiting on an
+   rwlock it just stopped reading, yielding if that leaves it
+   below a ready thread. */
+void thread_restore_by_rw(void)
+{
+	thread_refresh_priority(thread_current(), false);
+	thread_preemption();
+}
+
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
 	struct thread *cur = thread_current();
 
+	if (thread_mlfqs)
+		return;
+
 	// priority set
 	enum intr_level old = intr_disable();
 	cur->base_priority = new_priority;
 
 	thread_refresh_priority(cur, false);
 
-	if (!list_empty(&ready_list))
-	{
-		// 새로 변경 후 변경된 우선순위가 최우선이 아닌지 확인.
-		struct thread *ready_front = list_entry(list_front(&ready_list), struct thread, elem);
-		if (cur->priority < ready_front->priority)
-		{
-			thread_yield();
-		}
-	}
+	// 새로 변경 후 변경된 우선순위가 최우선이 아닌지 확인.
+	if (cur->priority < ready_max_priority())
+		thread_yield();
 	intr_set_level(old);
 }
 
@@ -518,30 +742,48 @@ int thread_get_priority(void)
 }
 
 /* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED)
+void thread_set_nice(int nice)
 {
-	/* TODO: Your implementation goes here */
+	struct thread *cur = thread_current();
+	enum intr_level old = intr_disable();
+
+	cur->nice = nice;
+	if (thread_mlfqs)
+	{
+		recent_cpu_catch_up(cur);
+		cur->base_priority = cur->priority = mlfqs_priority(cur);
+		thread_preemption();
+	}
+	intr_set_level(old);
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old = intr_disable();
+	int load = fp_round(fp_mul_int(load_avg, 100));
+
+	intr_set_level(old);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	struct thread *cur = thread_current();
+	enum intr_level old = intr_disable();
+	int recent_cpu;
+
+	recent_cpu_catch_up(cur);
+	recent_cpu = fp_round(fp_mul_int(cur->recent_cpu, 100));
+	intr_set_level(old);
+	return recent_cpu;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -612,6 +854,7 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->magic = THREAD_MAGIC;
 	list_init(&t->donators);
 	list_init(&t->fds);
+	ktimer_init(&t->sleep_timer, thread_awake, t);
 #ifdef USERPROG
 	list_init(&t->children);
 #endif
@@ -625,10 +868,52 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
+	struct thread *t;
+	int p;
+
+	if (ready_mask == 0)
 		return idle_thread;
-	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+	p = ready_max_priority();
+	t = list_entry(list_pop_front(&ready_queues[p]), struct thread, elem);
+	if (list_empty(&ready_queues[p]))
+		ready_mask &= ~(1ULL << p);
+	ready_cnt--;
+	return t;
+}
+
+/* Appends T to the run queue for its priority.  Interrupts must
+   be off. */
+static void
+ready_push(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	list_push_back(&ready_queues[t->priority], &t->elem);
+	ready_mask |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* Removes ready thread T from its run queue.  Interrupts must be
+   off. */
+static void
+ready_remove(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	list_remove(&t->elem);
+	if (list_empty(&ready_queues[t->priority]))
+		ready_mask &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* Returns the highest priority of any ready thread, or
+   PRI_MIN - 1 if none is ready. */
+static int
+ready_max_priority(void)
+{
+	if (ready_mask == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll(ready_mask);
 }
 
 /* Use iretq to launch the thread */
@@ -755,12 +1040,15 @@ schedule(void)
 
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(curr->status != THREAD_RUNNING);
+	ASSERT(curr->rcu_nesting == 0);
 	ASSERT(is_thread(next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
 	/* Start new time slice. */
 	thread_ticks = 0;
+	if (timer_tickless)
+		timer_set_deadline(next_deadline(next, timer_ticks()));
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -1,9 +1,11 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "bitmap.h"
+#include <string.h>
 #include "threads/mmu.h"
 #include "devices/disk.h"
 #include "threads/vaddr.h"
+#include "threads/malloc.h"
 #include "vm/vm.h"
 
 /* DO NOT MODIFY BELOW LINE */
@@ -18,6 +20,19 @@ static struct bitmap *swap_table; /* free/used swap slot을 관리한다. */
 static struct lock swap_lock;     /* 스왑 테이블 접근 동기화를 위한 락 */
 const size_t SECTORS_PER_PAGE = PGSIZE / DISK_SECTOR_SIZE;
 
+/* 🆁 next-fit 커서. 연달아 퇴출되는 페이지들이 이어진 슬롯을 받아
+ * 나중에 한 프로세스가 다시 깨어날 때 순차로 읽히게 한다. (swap_lock 보호) */
+static size_t swap_cursor;
+/* 🆁 slot → 그 슬롯에 내려가 있는 페이지 (readahead 용 역참조, swap_lock 보호) */
+static struct page **swap_owner;
+/* 🅲 slot → 그 슬롯을 가리키는 페이지 수. COW 공유 프레임이 내려가면 공유자들이
+ * 한 슬롯을 함께 가리키고, 마지막 페이지가 놓을 때 슬롯이 반납된다. (swap_lock 보호) */
+static unsigned *swap_refs;
+/* 🆁 swap-in 때 함께 읽어 올 뒤쪽 이웃 슬롯 수 (커널 옵션 -swap-ra=N, 0 이면 끔) */
+size_t swap_readahead;
+/* 🆁 readahead 한 번에 읽는 최대 페이지 수 */
+#define SWAP_RA_MAX 32
+
 static const struct page_operations anon_ops = {
     .swap_in = anon_swap_in,
     .swap_out = anon_swap_out,
@@ -35,9 +50,105 @@ void vm_anon_init(void) {
   swap_table = bitmap_create(disk_size(swap_disk) / SECTORS_PER_PAGE);
   if (swap_table == NULL)
     PANIC("Failed to create swap bitmap!");
+  swap_owner = calloc(bitmap_size(swap_table), sizeof *swap_owner);
+  if (swap_owner == NULL)
+    PANIC("Failed to create swap owner map!");
+  swap_refs = calloc(bitmap_size(swap_table), sizeof *swap_refs);
+  if (swap_refs == NULL)
+    PANIC("Failed to create swap reference counts!");
+  swap_cursor = 0;
   lock_init(&swap_lock);
 }
 
+/* 🆉 KVA 의 한 페이지가 전부 0 인가 */
+static bool page_is_all_zero(const void *kva) {
+  const uint64_t *p = kva;
+  for (size_t i = 0; i < PGSIZE / sizeof *p; i++)
+    if (p[i] != 0) return false;
+  return true;
+}
+
+/* 🆁 빈 슬롯 하나를 next-fit 으로 잡아 PAGE 에 묶는다. 없으면 BITMAP_ERROR. */
+static size_t swap_slot_alloc(struct page *page) {
+  lock_acquire(&swap_lock);
+  size_t slot = bitmap_scan_and_flip(swap_table, swap_cursor, 1, false);
+  if (slot == BITMAP_ERROR)  // 커서 뒤가 꽉 찼으면 처음부터 한 번 더
+    slot = bitmap_scan_and_flip(swap_table, 0, 1, false);
+  if (slot != BITMAP_ERROR) {
+    swap_owner[slot] = page;
+    swap_refs[slot] = 1;
+    swap_cursor = slot + 1;
+  }
+  lock_release(&swap_lock);
+  return slot;
+}
+
+/* 🆁 PAGE 가 SLOT 을 놓는다. 🅲 마지막으로 가리키던 페이지였을 때만 슬롯을 반납한다. */
+static void swap_slot_put(size_t slot, struct page *page) {
+  lock_acquire(&swap_lock);
+  if (--swap_refs[slot] == 0) {
+    bitmap_set(swap_table, slot, false);
+    swap_owner[slot] = NULL;
+  } else if (swap_owner[slot] == page) {
+    swap_owner[slot] = NULL;  // 🅲 readahead 가 떠난 페이지를 따라가지 않게
+  }
+  lock_release(&swap_lock);
+}
+
+/* 🅲 COW 공유 프레임을 내보낼 때, 대표 페이지 SRC 가 내려간 자리를 DST 도 가리키게 한다.
+ * 디스크에는 한 번만 쓰이고, 각 공유자는 다시 올라올 때 자기만의 프레임을 받는다. */
+void anon_swap_share(struct page *dst, const struct page *src) {
+  size_t slot = src->anon.swap_slot;
+
+  ASSERT(dst->operations->type == VM_ANON);
+  dst->anon.swap_slot = slot;
+  if (slot == SWAP_SLOT_ZERO || slot == BITMAP_ERROR) return;
+  lock_acquire(&swap_lock);
+  swap_refs[slot]++;
+  lock_release(&swap_lock);
+}
+
+/* 🆁 PAGE 가 내용을 다 가져갔으니 슬롯을 놓는다. */
+static void swap_release(struct page *page) {
+  struct anon_page *anon_page = &page->anon;
+  swap_slot_put(anon_page->swap_slot, page);
+  anon_page->swap_slot = BITMAP_ERROR;
+}
+
+/* 🆁 PAGE 의 슬롯 내용을 KVA 로 읽고 슬롯을 반납한다. */
+static void swap_read_page(struct page *page, void *kva) {
+  /* 한 페이지(8섹터)를 명령 하나로 읽는다 */
+  disk_read_multiple(swap_disk, page->anon.swap_slot * SECTORS_PER_PAGE, SECTORS_PER_PAGE, kva);
+  swap_release(page);
+}
+
+/* 🆁 SLOT 바로 뒤의 이웃 슬롯 중 같은 프로세스의 페이지를 여유 프레임이 있는 만큼
+ * 미리 올린다. 같이 내려간 페이지는 곧 같이 불릴 가능성이 높다는 가정이다.
+ * 퇴출을 일으키지 않으며, 남의 페이지나 빈 슬롯을 만나면 멈춘다.
+ * 이어진 슬롯들을 이어진 프레임들로 명령 하나에 읽고, 매핑된 페이지만 슬롯을 놓는다. */
+static void swap_readahead_after(size_t slot) {
+  struct thread *cur = thread_current();
+  struct page *run[SWAP_RA_MAX];
+  size_t max = swap_readahead < SWAP_RA_MAX ? swap_readahead : SWAP_RA_MAX;
+  size_t cnt = 0;
+
+  lock_acquire(&swap_lock);
+  while (cnt < max && slot + 1 + cnt < bitmap_size(swap_table)) {
+    struct page *np = swap_owner[slot + 1 + cnt];
+    if (np == NULL || np->owner != cur || np->frame != NULL) break;
+    run[cnt++] = np;
+  }
+  lock_release(&swap_lock);
+
+  /* 이웃 페이지는 cur 만 건드리므로 락을 놓은 뒤에도 그대로다.
+   * 여유 프레임이 없으면 추측 읽기는 하지 않는다 */
+  cnt = vm_prefetch_frames(run, cnt);
+  if (cnt == 0) return;
+  disk_read_multiple(swap_disk, (slot + 1) * SECTORS_PER_PAGE, cnt * SECTORS_PER_PAGE, run[0]->frame->kva);
+  for (size_t i = 0; i < cnt; i++)
+    if (vm_prefetch_done(run[i])) swap_release(run[i]);
+}
+
 /* Initialize the file mapping */
 bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
   /* Set up the handler */
@@ -54,23 +165,21 @@ static bool anon_swap_in(struct page *page, void *kva) {  // 디스크->메모
   struct anon_page *anon_page = &page->anon;
 
   size_t swap_index = anon_page->swap_slot;
-  if (!bitmap_test(swap_table, swap_index)) {
-    return false;
+  if (swap_index == SWAP_SLOT_ZERO) {  // 🆉 0 페이지로 내려갔던 페이지는 읽을 게 없다
+    memset(kva, 0, PGSIZE);
+    anon_page->swap_slot = BITMAP_ERROR;
+    return true;
   }
   if (swap_index == BITMAP_ERROR) {
     PANIC("swap_in index is ERROR");
     return false;
   }
-
-  for (int i = 0; i < 8; i++) {
-    disk_read(swap_disk, swap_index * 8 + i, kva + i * DISK_SECTOR_SIZE);
+  if (!bitmap_test(swap_table, swap_index)) {
+    return false;
   }
 
-  page->frame->kva = kva;
-
-  lock_acquire(&swap_lock);
-  bitmap_set(swap_table, swap_index, false);
-  lock_release(&swap_lock);
+  swap_read_page(page, kva);
+  if (swap_readahead > 0) swap_readahead_after(swap_index);
 
   return true;
 }
@@ -82,25 +191,22 @@ static bool anon_swap_out(struct page *page) {  // 메모리->디스크
   }
   /* 익명 페이지 정보 획득 */
   struct anon_page *anon_page = &page->anon;
-  lock_acquire(&swap_lock);
-  /* 스왑 테이블에서 빈 슬롯 찾아서 할당 */
-  size_t swap_index = bitmap_scan_and_flip(swap_table, 0, 1, false);
-  lock_release(&swap_lock);
+  /* 🆉 전부 0 인 페이지는 슬롯도 디스크 쓰기도 없이 표시만 해 둔다 */
+  if (page_is_all_zero(page->frame->kva)) {
+    anon_page->swap_slot = SWAP_SLOT_ZERO;
+    return true;
+  }
+  /* 스왑 테이블에서 빈 슬롯 찾아서 할당 (🆁 next-fit) */
+  size_t swap_index = swap_slot_alloc(page);
   /* 빈 슬롯을 찾지 못한 경우 실패 반환 */
   if (swap_index == BITMAP_ERROR) {
     return false;
   }
   anon_page->swap_slot = swap_index;
-  /* 페이지 내용을 스왑 디스크에 섹터 단위로 기록 */
-  for (size_t i = 0; i < SECTORS_PER_PAGE; i++) {
-    disk_write(swap_disk, swap_index * SECTORS_PER_PAGE + i, page->frame->kva + i * DISK_SECTOR_SIZE);
-  }
+  /* 페이지 내용을 스왑 디스크에 명령 하나로 기록 (섹터마다 명령을 내지 않는다) */
+  disk_write_multiple(swap_disk, swap_index * SECTORS_PER_PAGE, SECTORS_PER_PAGE, page->frame->kva);
 
-  /* 페이지에 할당된 스왑 슬롯 번호 저장 및 프레임 정보 초기화 */
-  page->frame->page = NULL;
-  page->frame = NULL; /* 물리 프레임에서 제거됨을 표시 */
-
-  pml4_clear_page(thread_current()->pml4, page->va);
+  /* 🅵 매핑 제거와 프레임 연결 해제는 vm_evict_frame() 이 주인의 pml4 로 처리한다 */
   return true;
 }
 
@@ -111,6 +217,9 @@ static bool anon_swap_out(struct page *page) {  // 메모리->디스크
  * @param page 삭제할 익명 페이지 구조체
  */
 static void anon_destroy(struct page *page) {
+  /* 🅲 올라와 있던 프레임(COW 공유 포함)을 먼저 놓는다 */
+  vm_release_frame(page);
+
   /* 스왑 디스크나 스왑 테이블이 초기화되지 않은 경우 early return */
   if (swap_disk == NULL || swap_table == NULL) {
     return;
@@ -120,11 +229,9 @@ static void anon_destroy(struct page *page) {
   struct anon_page *anon_page = &page->anon;
 
   /* 페이지가 스왑 슬롯을 점유하고 있는 경우에만 해제 작업을 수행 */
-  if (anon_page->swap_slot != BITMAP_ERROR) {
-    /* 스왑 테이블 접근을 위한 락 획득 */
-    lock_acquire(&swap_lock);
+  if (anon_page->swap_slot != BITMAP_ERROR && anon_page->swap_slot != SWAP_SLOT_ZERO) {
     /* 비트맵에서 해당 슬롯을 사용 가능 상태로 표시 */
-    bitmap_set(swap_table, anon_page->swap_slot, false);
-    lock_release(&swap_lock);
+    swap_slot_put(anon_page->swap_slot, page);
+    anon_page->swap_slot = BITMAP_ERROR;
   }
 }
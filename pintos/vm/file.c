@@ -7,7 +7,6 @@
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
 #include "vm/vm.h"
-#include "userprog/syscall.h"   // filesys_lock 선언 사용
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -77,9 +76,8 @@ static bool file_backed_swap_in(struct page *page, void *kva) {
 	ASSERT(file_page->file != NULL);
 	ASSERT(kva != NULL);
 
-	lock_acquire(&filesys_lock);
+	/* 파일 시스템 락은 inode 단위라서 다른 파일의 I/O 를 기다리지 않는다 */
 	off_t r = file_read_at(file_page->file, kva, file_page->read_bytes, file_page->offset);
-	lock_release(&filesys_lock);
 
 	if (r != (off_t)file_page->read_bytes) return false;
 
@@ -95,24 +93,19 @@ static bool file_backed_swap_out(struct page *page) {
 	struct file_page *file_page = &page->file;
 	ASSERT(file_page->file != NULL);
 
-	struct thread *t = thread_current();
-	void *kva = page->frame ? page->frame->kva : NULL;
+	if (page->frame == NULL) return true;
+	/* 🅵 퇴출은 다른 스레드의 폴트에서도 일어나므로 dirty 는 주인의 pml4 에서 본다 */
+	uint64_t *pml4 = page->frame->pml4;
+	void *kva = page->frame->kva;
 
 	/* 페이지 테이블 dirty 확인 후, 더티면 해당 구간만 write-back */
-	if (pml4_is_dirty(t->pml4, page->va) && kva != NULL && file_page->read_bytes > 0) {
-		lock_acquire(&filesys_lock);
+	if (pml4_is_dirty(pml4, page->va) && file_page->read_bytes > 0) {
 		off_t w = file_write_at(file_page->file, kva, file_page->read_bytes, file_page->offset);
-		lock_release(&filesys_lock);
 		if (w != (off_t)file_page->read_bytes) return false;
-		pml4_set_dirty(t->pml4, page->va, false);
+		pml4_set_dirty(pml4, page->va, false);
 	}
 
-	/* 이 시점에서 물리 매핑 해제 (프레임 해제는 프레임 계층이 처리) */
-	pml4_clear_page(t->pml4, page->va);
-	if (page->frame) {
-		page->frame->page = NULL; /* 역참조 해제만 */
-		page->frame = NULL;
-	}
+	/* 매핑 제거와 프레임 연결 해제는 프레임 계층(vm_evict_frame)이 처리 */
 	return true;
 }
 
@@ -133,12 +126,13 @@ static void file_backed_destroy(struct page *page) {
 	struct thread *t = thread_current();
 	if (page->frame && pml4_is_dirty(t->pml4, page->va)) {
 		void *kva = page->frame->kva;
-		lock_acquire(&filesys_lock);
 		(void)file_write_at(file_page->file, kva, file_page->read_bytes, file_page->offset);
-		lock_release(&filesys_lock);
-		pml4_set_dirty(t->pml4, page->va, false); // 이 시점에는 락이 없어도 안전합니다.
+		pml4_set_dirty(t->pml4, page->va, false);
 	}
 
+	/* 🅲 write-back 이 끝났으니 프레임을 놓는다 */
+	vm_release_frame(page);
+
 	if (file_page->file) {
 		file_close(file_page->file);  // **여기서 닫을 수 있게 do_mmap에서 page마다 file_reopen() 사용**
 		file_page->file = NULL;
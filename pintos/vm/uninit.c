@@ -10,7 +10,10 @@
 
 #include "vm/uninit.h"
 
+#include <string.h>
+
 #include "threads/malloc.h"  // 🅒 free() 선언
+#include "threads/vaddr.h"   // 🆉 PGSIZE
 #include "vm/vm.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
@@ -52,8 +55,12 @@ uninit_initialize(struct page *page, void *kva) {
   void *aux = uninit->aux;
 
   /* TODO: You may need to fix this function. */
-  return uninit->page_initializer(page, uninit->type, kva) &&
-         (init ? init(page, aux) : true);
+  if (!uninit->page_initializer(page, uninit->type, kva)) return false;
+  if (init != NULL) return init(page, aux);
+  /* 🆉 초기화 함수가 없는 순수 익명 페이지(스택 등)는 0 으로 시작한다.
+   * 읽기 폴트에서는 zero 프레임으로 보였으므로, 재활용된 프레임의 옛 내용이 드러나면 안 된다 */
+  memset(kva, 0, PGSIZE);
+  return true;
 }
 
 /* Free the resources hold by uninit_page. Although most of pages are transmuted
@@ -65,6 +72,7 @@ static void uninit_destroy(struct page *page) {
   struct uninit_page *uninit = &page->uninit;
   /* TODO: Fill this function.
    * TODO: If you don't have anything to do, just return. */
+  vm_release_frame(page);  // 🆉 읽기만 해서 zero 프레임이 걸려 있을 수 있다
   if (uninit->type == VM_UNINIT) {
     free(uninit->aux);
     uninit->aux = NULL;
@@ -2,6 +2,7 @@
 #include "vm/vm.h"  // SPT/페이지 구조체(struct page, spt) 선언들
 
 #include <stdint.h>  // 🅢 uintptr_t: 포인터 비교 시 정수 변환용
+#include <stdio.h>   // 🅠 vm_print_stats
 
 #include "hash.h"
 #include "lib/kernel/hash.h"  // 🅢 Pintos 커널 해시 테이블 API(hash_init/hash_find/...)
@@ -16,18 +17,57 @@
 // 🅒
 #include "lib/string.h"
 
-// 🅴
-#include "lib/kernel/list.h"  // frame table용
-
-/* Frame table node: frame 포인터 + 리스트 엘리먼트 */
-struct frame_node {
-  struct frame *f;
-  struct list_elem elem;
-};
+// 🅲
+#include "threads/mmu.h"  // pml4_set_page / pml4_clear_page (COW 매핑 조작)
 
-/* Frame table (second-chance) */
-static struct list frame_table;      /* 전체 프레임 목록 */
-static struct list_elem *clock_hand; /* 시계 바늘 */
+// 🅴
+#include "lib/kernel/list.h"  // frame->sharers 용
+
+/* 🅵 Frame table (second-chance).
+ * user pool 의 페이지 번호(palloc_user_page_idx)로 바로 인덱싱되는 배열이다.
+ * 부팅 때 한 번 할당하므로 kva → frame 역참조, 시계 바늘 이동이 모두 O(1) 이다. */
+static struct frame *frame_table; /* 🅵 frame_table[frame_cnt] */
+static size_t frame_cnt;          /* 🅵 user pool 페이지 슬롯 수 */
+static size_t clock_hand;         /* 🅵 다음에 검사할 슬롯 인덱스 */
+static struct lock frame_lock;    /* 🅲 frame_table 과 공유 카운트 보호 */
+
+/* 🅠 2Q 교체 정책 상태. 모두 frame_lock 으로 보호한다.
+ * 처음 올라온 페이지는 A1in(FIFO)에 들어가고, A1in 에서 쫓겨난 페이지는 page->ghost_seq
+ * 에 시점이 찍혀 A1out(ghost) 역할을 한다. ghost 가 식기 전에 다시 불리면 Am 으로 들어간다.
+ * 한 번 훑고 지나가는 순차 접근은 A1in 만 돌고 나가므로 Am 의 hot 집합을 밀어내지 못한다. */
+enum vm_policy vm_policy = VM_POLICY_CLOCK;
+static struct list q_a1in;  /* 🅠 FRAME_A1IN 프레임들 (앞이 가장 오래됨) */
+static struct list q_am;    /* 🅠 FRAME_AM 프레임들 (앞이 시계 바늘) */
+static size_t a1in_cnt;     /* 🅠 q_a1in 길이 */
+static size_t am_cnt;       /* 🅠 q_am 길이 */
+static uint64_t evict_seq;  /* 🅠 A1in 퇴출 누적 수. ghost 의 나이를 잰다 */
+
+/* 🅠 폴트/퇴출 통계 (vm_print_stats) */
+static long long fault_cnt;     /* vm_try_handle_fault 호출 수 */
+static long long pagein_cnt;    /* 실제로 프레임을 채운 수 */
+static long long evict_cnt;     /* 퇴출 수 */
+static long long ghost_hit_cnt; /* 2Q: ghost 적중으로 Am 에 들어간 수 */
+static long long readahead_cnt; /* 🆁 swap readahead 로 미리 올린 수 */
+static long long pageout_cnt;   /* 🅿 pageout 데몬이 내보낸 수 */
+static long long zero_map_cnt;  /* 🆉 zero 프레임을 건 수 */
+
+/* 🆉 모든 프로세스가 읽기 전용으로 함께 거는 0 으로 찬 페이지 (커널 풀, frame_table 밖) */
+static void *zero_kva;
+
+/* 🅿 pageout 데몬. 여유 user 프레임이 vm_free_low 아래로 떨어지면 깨어나
+ * vm_free_high 까지 미리 내보내 둔다. 폴트 경로는 대개 palloc 만으로 프레임을 얻고
+ * 더티 victim 의 write-back 을 기다리지 않는다. SIZE_MAX(미지정)면 vm_init() 이 정하고,
+ * low 가 0 이면 데몬을 띄우지 않는다. */
+size_t vm_free_low = SIZE_MAX, vm_free_high = SIZE_MAX;
+static size_t frame_avail;         /* 🅿 vm_init 시점의 여유 user 페이지 수 */
+static size_t frame_used;          /* 🅿 FRAME_USED 슬롯 수 */
+static struct condition pageout_cond; /* 🅿 데몬을 깨운다 */
+static struct condition evict_cond;   /* 🅿 FRAME_EVICTING 이 풀릴 때 */
+static void vm_pageoutd(void *aux);
+
+/* 🅲 SPT 는 struct thread 안에 박혀 있고 struct thread 는 자기 페이지 맨 앞에
+ * 놓이므로(running_thread() 와 같은 원리) SPT 주소로 주인 스레드를 역산한다. */
+#define spt_owner(spt) ((struct thread *)pg_round_down(spt))
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -35,15 +75,38 @@ void vm_init(void) {
   vm_anon_init();
   vm_file_init();
 #ifdef EFILESYS /* For project 4 */
-  pagecache_init();
+  page_cache_init();
 #endif
   register_inspect_intr();
   /* DO NOT MODIFY UPPER LINES. */
   /* TODO: Your code goes here. */
 
   /*🅴 frame table 초기화 */
-  list_init(&frame_table);  // 테이블 초기화
-  clock_hand = NULL;        // 바늘 초기화
+  frame_cnt = palloc_user_page_cnt();
+  frame_table = calloc(frame_cnt, sizeof *frame_table);
+  if (frame_table == NULL) PANIC("vm_init: frame table 할당 실패");
+  for (size_t i = 0; i < frame_cnt; i++) list_init(&frame_table[i].sharers);
+  clock_hand = 0;  // 바늘 초기화
+  lock_init(&frame_lock);
+  list_init(&q_a1in);
+  list_init(&q_am);
+
+  /* 🅿 워터마크 기본값: 여유 프레임의 1/32 ~ 1/16 */
+  zero_kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+  frame_avail = palloc_user_free_cnt();
+  if (vm_free_low == SIZE_MAX) vm_free_low = frame_avail / 32;
+  if (vm_free_high == SIZE_MAX || vm_free_high < vm_free_low) vm_free_high = vm_free_low * 2;
+  cond_init(&pageout_cond);
+  cond_init(&evict_cond);
+  if (vm_free_low > 0) thread_create("pageoutd", PRI_DEFAULT, vm_pageoutd, NULL);
+}
+
+/* 🅠 Prints paging statistics. */
+void vm_print_stats(void) {
+  printf("VM: %lld faults, %lld page-ins, %lld zero maps, %lld evictions (%lld in background), "
+         "%lld ghost hits, %lld readahead (%s)\n",
+         fault_cnt, pagein_cnt, zero_map_cnt, evict_cnt, pageout_cnt, ghost_hit_cnt, readahead_cnt,
+         vm_policy == VM_POLICY_2Q ? "2q" : "clock");
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -63,6 +126,84 @@ enum vm_type page_get_type(struct page *page) {
 static struct frame *vm_get_victim(void);
 static bool vm_do_claim_page(struct page *page);
 static struct frame *vm_evict_frame(void);
+static struct frame *vm_get_frame_locked(void);
+static struct frame *frame_claim_slot(void *kva);
+
+/* 🅵 대표 페이지가 바뀔 때마다 owner/pml4 를 그 페이지 주인 것으로 맞춘다. */
+static void frame_set_rep(struct frame *f) {
+  if (f->share_cnt > 0) {
+    f->page = list_entry(list_front(&f->sharers), struct page, frame_elem);
+    f->owner = f->page->owner;
+    f->pml4 = f->owner->pml4;
+  } else {
+    f->page = NULL;
+    f->owner = NULL;
+    f->pml4 = NULL;
+  }
+}
+
+/* 🅠 2Q: 새로 채워진 프레임을 큐에 넣는다. 식지 않은 ghost 였다면 Am, 아니면 A1in. */
+static void policy_admit(struct frame *f, struct page *page) {
+  if (vm_policy != VM_POLICY_2Q) return;
+
+  /* ghost 는 A1in 크기의 두 배 정도(frame_cnt / 2 번의 퇴출) 동안만 기억한다 */
+  if (page->ghost_seq != 0 && evict_seq - page->ghost_seq < frame_cnt / 2) {
+    f->flags |= FRAME_AM;
+    list_push_back(&q_am, &f->q_elem);
+    am_cnt++;
+    ghost_hit_cnt++;
+  } else {
+    f->flags |= FRAME_A1IN;
+    list_push_back(&q_a1in, &f->q_elem);
+    a1in_cnt++;
+  }
+  page->ghost_seq = 0;
+}
+
+/* 🅠 2Q: 마지막 공유자가 떠난 프레임을 큐에서 뺀다. */
+static void policy_remove(struct frame *f) {
+  if (f->flags & FRAME_A1IN) a1in_cnt--;
+  if (f->flags & FRAME_AM) am_cnt--;
+  if (f->flags & (FRAME_A1IN | FRAME_AM)) list_remove(&f->q_elem);
+  f->flags &= ~(FRAME_A1IN | FRAME_AM);
+}
+
+/* 🅲 PAGE 를 프레임 F 의 공유자로 등록한다. frame_lock 을 쥔 상태에서 호출. */
+static void frame_link(struct frame *f, struct page *page) {
+  list_push_back(&f->sharers, &page->frame_elem);
+  if (f->share_cnt++ == 0) policy_admit(f, page);
+  frame_set_rep(f);
+  page->frame = f;
+  page->owner->frame_cnt++;
+}
+
+/* 🅲 PAGE 를 프레임 F 의 공유자 목록에서 뺀다. frame_lock 을 쥔 상태에서 호출. */
+static void frame_unlink(struct frame *f, struct page *page) {
+  list_remove(&page->frame_elem);
+  if (--f->share_cnt == 0) policy_remove(f);
+  frame_set_rep(f);
+  page->frame = NULL;
+  page->owner->frame_cnt--;
+}
+
+/* 🅲 공유자가 하나도 남지 않은 프레임의 물리 페이지를 반납하고 슬롯을 비운다.
+ * frame_lock 을 쥔 상태에서 호출. */
+static void frame_free(struct frame *f) {
+  ASSERT(f->share_cnt == 0);
+
+  frame_used--;
+  palloc_free_page(f->kva);
+  f->kva = NULL;
+  f->pin_cnt = 0;
+  f->flags = 0;
+}
+
+/* 🅵 KVA 를 들고 있는 frame_table 슬롯. user pool 밖의 주소면 NULL. */
+struct frame *vm_frame_lookup(void *kva) {
+  size_t idx = palloc_user_page_idx(pg_round_down(kva));
+  if (idx == SIZE_MAX || idx >= frame_cnt) return NULL;
+  return &frame_table[idx];
+}
 
 /*🅢 [키->해시값] 해시테이블이 쓸 해시값을 계산 -> 해시테이블이 버킷을 선택*/
 static unsigned page_hash(const struct hash_elem *e, void *aux) {
@@ -115,6 +256,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
     }
 
     page->writable = writable;
+    page->owner = thread_current();  // 🅵 uninit_new() 가 구조체를 덮어쓰므로 그 뒤에 채운다
 
     /* TODO: Insert the page into the spt. */
     if (!spt_insert_page(spt, page)) {
@@ -168,59 +310,148 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
   vm_dealloc_page(page);
 }
 
-/* 🅴 Get the struct frame, that will be evicted. */
-static struct frame *vm_get_victim(void) {
-  if (list_empty(&frame_table)) return NULL;
-  if (clock_hand == NULL) clock_hand = list_begin(&frame_table);
+/* 🅠 지금 내보내도 되는 프레임인가 (적재 중이면 안 됨. COW 공유 중이면 모든 공유자에서 내린다) */
+static bool frame_evictable(const struct frame *f) {
+  return f->page != NULL && f->pin_cnt == 0;
+}
+
+/* 🅠 2Q: A1in 은 FIFO 이므로 가장 오래된 내보낼 수 있는 프레임을 고른다. */
+static struct frame *victim_a1in(void) {
+  for (struct list_elem *e = list_begin(&q_a1in); e != list_end(&q_a1in); e = list_next(e)) {
+    struct frame *f = list_entry(e, struct frame, q_elem);
+    if (frame_evictable(f)) return f;
+  }
+  return NULL;
+}
+
+/* 🅠 2Q: Am 은 second-chance. 접근된 프레임은 비트를 떨어뜨리고 뒤로 보낸다. */
+static struct frame *victim_am(void) {
+  for (size_t i = 0; i < 2 * am_cnt; i++) {
+    struct frame *f = list_entry(list_pop_front(&q_am), struct frame, q_elem);
+    list_push_back(&q_am, &f->q_elem);
+    if (!frame_evictable(f)) continue;
+    if (!pml4_is_accessed(f->pml4, f->page->va)) return f;
+    pml4_set_accessed(f->pml4, f->page->va, false);
+  }
+  return NULL;
+}
 
-  size_t n = list_size(&frame_table);
-  struct frame *fallback = NULL;
+/* 🅠 2Q victim: A1in 이 제 몫(프레임의 1/4)을 넘었거나 Am 이 비었으면 A1in 에서,
+ * 아니면 Am 에서 고른다. 한쪽이 전부 고정돼 있으면 다른 쪽으로 넘어간다. */
+static struct frame *vm_get_victim_2q(void) {
+  struct frame *f = NULL;
+  if (a1in_cnt > frame_cnt / 4 || list_empty(&q_am)) f = victim_a1in();
+  if (f == NULL) f = victim_am();
+  if (f == NULL) f = victim_a1in();
+  return f;
+}
 
-  for (size_t i = 0; i < n; i++) {
-    if (clock_hand == list_end(&frame_table))
-      clock_hand = list_begin(&frame_table);
+/* 🅴 Get the struct frame, that will be evicted. */
+static struct frame *vm_get_victim(void) {
+  if (vm_policy == VM_POLICY_2Q) return vm_get_victim_2q();
 
-    struct frame_node *nd = list_entry(clock_hand, struct frame_node, elem);
-    clock_hand = list_next(clock_hand);
+  /* 🅵 두 바퀴면 첫 바퀴에서 accessed 를 떨어뜨린 프레임을 반드시 다시 만난다 */
+  for (size_t i = 0; i < 2 * frame_cnt; i++) {
+    struct frame *f = &frame_table[clock_hand];
+    clock_hand = (clock_hand + 1) % frame_cnt;
 
-    struct frame *f = nd->f;
-    if (f->page == NULL) return f;  // 빈 프레임은 즉시 사용
+    if (!(f->flags & FRAME_USED) || f->pin_cnt > 0) continue;  // 빈 슬롯, 적재 중인 프레임
+    if (f->page == NULL) return f;   // 빈 프레임은 즉시 사용
 
+    /* 🅵 accessed 비트는 현재 스레드가 아닌 주인의 pml4 에서 본다 */
     struct page *p = f->page;
-    if (!pml4_is_accessed(thread_current()->pml4, p->va)) {
+    if (!pml4_is_accessed(f->pml4, p->va)) {
       return f;  // accessed==0 → 희생자 확정
     }
     /* accessed==1 → 한번만 기회를 주고 떨어뜨림 */
-    pml4_set_accessed(thread_current()->pml4, p->va, false);
-    fallback = f;  // 전부 1이면 마지막 본 f를 사용
+    pml4_set_accessed(f->pml4, p->va, false);
   }
-  return fallback;  // 한 바퀴 내에 반드시 반환
+  return NULL;  // 모두 고정됨
+}
+
+/* 🅿 데몬이 PAGE 의 프레임을 내보내는 중이면 끝날 때까지 기다린다.
+ * frame_lock 을 쥔 상태에서 호출. 돌아온 뒤 page->frame 이 NULL 이면 내보내진 것. */
+static void frame_wait_stable(struct page *page) {
+  while (page->frame != NULL && (page->frame->flags & FRAME_EVICTING))
+    cond_wait(&evict_cond, &frame_lock);
 }
 
 /* 🅴 Evict one page and return the corresponding frame.
  * Return NULL on error.*/
+/* 🅿 frame_lock 을 쥔 채로 불리지만 swap_out 의 디스크 I/O 동안은 락을 놓는다.
+ * 그동안 victim 은 FRAME_EVICTING 으로 고정되고, 그 페이지를 건드리려는 쪽은
+ * frame_wait_stable() 에서 기다린다.
+ * 🅲 COW 공유 중인 프레임은 대표 페이지로 한 번만 내려 쓰고 공유자 모두가 그 슬롯을 가리킨다. */
 static struct frame *vm_evict_frame(void) {
   struct frame *victim = vm_get_victim();
   if (!victim) return NULL;
 
   if (victim->page) {
     struct page *vp = victim->page;
-
-    /* 0) 당장 다시 접근되며 accessed가 재점화되는 걸 막기 위해 매핑 제거 먼저 */
-    pml4_clear_page(thread_current()->pml4, vp->va);
+    struct list_elem *e;
+
+    /* 0) 당장 다시 접근되며 accessed가 재점화되는 걸 막기 위해 매핑 제거 먼저 (🅲 모든 공유자) */
+    victim->pin_cnt++;
+    victim->flags |= FRAME_EVICTING;
+    for (e = list_begin(&victim->sharers); e != list_end(&victim->sharers); e = list_next(e)) {
+      struct page *p = list_entry(e, struct page, frame_elem);
+      pml4_clear_page(p->owner->pml4, p->va);
+    }
 
     /* 1) 백엔드로 스왑아웃 시도 */
-    if (!swap_out(vp)) {
-      /* 실패 시 매핑을 복구해주고 포기 */
-      pml4_set_page(thread_current()->pml4, vp->va, victim->kva, vp->writable);
+    lock_release(&frame_lock);
+    bool ok = swap_out(vp);
+    lock_acquire(&frame_lock);
+    victim->flags &= ~FRAME_EVICTING;
+    cond_broadcast(&evict_cond, &frame_lock);
+    if (!ok) {
+      /* 실패 시 매핑을 복구해주고 포기 (🅲 공유 중이면 읽기 전용으로) */
+      bool shared = victim->share_cnt > 1;
+      for (e = list_begin(&victim->sharers); e != list_end(&victim->sharers); e = list_next(e)) {
+        struct page *p = list_entry(e, struct page, frame_elem);
+        pml4_set_page(p->owner->pml4, p->va, victim->kva, p->writable && !shared);
+      }
+      victim->pin_cnt--;
       return NULL;
     }
 
-    /* 2) 양방향 연결 해제(프레임 재사용 준비) */
-    vp->frame = NULL;
-    victim->page = NULL;
+    /* 2) 양방향 연결 해제(프레임 재사용 준비). 🅲 다른 공유자는 대표가 내려간 슬롯을 함께 가리킨다 */
+    if (victim->flags & FRAME_A1IN) vp->ghost_seq = ++evict_seq;  // 🅠 A1out 에 기록
+    while (!list_empty(&victim->sharers)) {
+      struct page *p = list_entry(list_front(&victim->sharers), struct page, frame_elem);
+      if (p != vp) anon_swap_share(p, vp);
+      frame_unlink(victim, p);
+    }
+    evict_cnt++;
+  }
+  victim->pin_cnt = 1;  // 🅵 새 주인이 swap_in 을 끝낼 때까지 고정
+  return victim;        // 같은 kva를 재사용
+}
+
+/* 🅿 여유 user 프레임 수. frame_lock 을 쥔 상태에서 호출. */
+static size_t frame_free_cnt(void) {
+  return frame_used < frame_avail ? frame_avail - frame_used : 0;
+}
+
+/* 🅿 pageout 데몬 본체. 깨워지면 여유 프레임이 vm_free_high 가 될 때까지 내보낸다. */
+static void vm_pageoutd(void *aux UNUSED) {
+  lock_acquire(&frame_lock);
+  for (;;) {
+    cond_wait(&pageout_cond, &frame_lock);
+    while (frame_free_cnt() < vm_free_high) {
+      struct frame *f = vm_evict_frame();
+      if (f == NULL) break;  // 전부 고정돼 있으면 다음 호출까지 쉰다
+      frame_free(f);
+      pageout_cnt++;
+    }
+#ifdef EFILESYS
+    /* 🅿 메모리가 부족할 때는 버퍼 캐시의 지연 쓰기도 디스크로 내려 깨끗하게 만든다.
+     * 디스크 I/O 동안 폴트가 막히지 않도록 frame_lock 은 놓는다. */
+    lock_release(&frame_lock);
+    page_cache_flush();
+    lock_acquire(&frame_lock);
+#endif
   }
-  return victim;  // 같은 kva를 재사용
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
@@ -229,47 +460,167 @@ static struct frame *vm_evict_frame(void) {
  * space.*/
 /*🅕 🅴 프레임 실물 확보(+프레임 메타 생성): PANIC → 퇴출로 회복, 테이블 등록*/
 static struct frame *vm_get_frame(void) {
+  lock_acquire(&frame_lock);
+  struct frame *frame = vm_get_frame_locked();
+  lock_release(&frame_lock);
+  return frame;
+}
+
+/* 🅲 vm_get_frame() 본체. frame_lock 을 쥔 채로 호출해야 한다. */
+static struct frame *vm_get_frame_locked(void) {
   void *kva = palloc_get_page(PAL_USER);
-  if (kva == NULL) return vm_evict_frame();  // 부족하면 퇴출 시도
+  /* 🅿 여유가 low 아래면 데몬을 깨워 다음 폴트를 위해 미리 비워 둔다 */
+  if (frame_free_cnt() < vm_free_low) cond_signal(&pageout_cond, &frame_lock);
+  if (kva == NULL) return vm_evict_frame();  // 부족하면 동기적으로 퇴출
 
-  struct frame *frame = malloc(sizeof *frame);
-  if (!frame) {  // 안전 반환
-    palloc_free_page(kva);
-    return NULL;
-  }
+  return frame_claim_slot(kva);
+}
+
+/* 🅵 palloc 으로 막 받은 KVA 의 슬롯을 사용 중으로 채운다. 슬롯은 미리 있으므로
+ * 할당은 없다. swap_in 이 끝날 때까지 고정된 채로 돌려준다. frame_lock 을 쥔 상태에서 호출. */
+static struct frame *frame_claim_slot(void *kva) {
+  struct frame *frame = vm_frame_lookup(kva);
+  ASSERT(frame != NULL && !(frame->flags & FRAME_USED));
   frame->kva = kva;
-  frame->page = NULL;
+  frame->flags = FRAME_USED;
+  frame->pin_cnt = 1;
+  frame_used++;
+  ASSERT(frame->share_cnt == 0 && list_empty(&frame->sharers));
+  return frame;
+}
 
-  /* frame_table에는 frame_node를 넣는다 */
-  struct frame_node *node = malloc(sizeof *node);  // 테이블에 등록
-  if (!node) {
-    palloc_free_page(kva);
-    free(frame);
-    return NULL;
+/* 🆁 swap readahead 용. 여유 프레임이 있을 때만(퇴출 없이) PAGES[0..CNT) 에 물리적으로
+ * 이어진 프레임을 차례로 묶어 고정한다. 한 번의 디스크 명령으로 채울 수 있게 하려는 것이라
+ * 이어진 프레임이 모자라면 뒤쪽 페이지를 포기하고, 묶은 수를 돌려준다.
+ * 내용을 채운 뒤 페이지마다 vm_prefetch_done() 을 불러야 한다. */
+size_t vm_prefetch_frames(struct page **pages, size_t cnt) {
+  uint8_t *kva = NULL;
+
+  lock_acquire(&frame_lock);
+  for (; cnt > 0; cnt--)
+    if ((kva = palloc_get_multiple(PAL_USER, cnt)) != NULL) break;
+  for (size_t i = 0; i < cnt; i++) frame_link(frame_claim_slot(kva + i * PGSIZE), pages[i]);
+  lock_release(&frame_lock);
+  return cnt;
+}
+
+/* 🆁 미리 채운 PAGE 를 주인의 pml4 에 매핑하고 고정을 푼다. accessed 가 0 인 채로
+ * 걸리므로 실제로 쓰이지 않으면 다음 퇴출 때 먼저 나간다.
+ * 매핑에 실패하면 프레임을 버리고 false. 페이지는 스왑에 그대로 남는다. */
+bool vm_prefetch_done(struct page *page) {
+  struct frame *frame = page->frame;
+  bool mapped;
+
+  lock_acquire(&frame_lock);
+  mapped = pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable);
+  if (mapped) {
+    frame->pin_cnt--;
+    readahead_cnt++;
+  } else {
+    frame_unlink(frame, page);
+    frame_free(frame);
   }
-  node->f = frame;
-  list_push_back(&frame_table, &node->elem);  // 목록 관리
-  if (clock_hand == NULL) clock_hand = list_begin(&frame_table);
+  lock_release(&frame_lock);
+  return mapped;
+}
 
-  return frame;
+/* 🅲 PAGE 가 잡고 있던 프레임을 놓는다. 매핑을 지워 pml4_destroy() 가 공유 프레임을
+ * 이중 해제하지 않게 하고, 마지막 공유자였다면 프레임까지 반납한다.
+ * 각 페이지 타입의 destroy 에서 (write-back 이 끝난 뒤) 호출된다. */
+void vm_release_frame(struct page *page) {
+  /* 🆉 공유 zero 프레임은 pml4_destroy() 가 반납하지 않도록 매핑만 지운다 */
+  if (page->zero_mapped) {
+    struct thread *t = thread_current();
+    if (t->pml4 != NULL) pml4_clear_page(t->pml4, page->va);
+    page->zero_mapped = false;
+  }
+
+  lock_acquire(&frame_lock);
+  frame_wait_stable(page);
+  struct frame *f = page->frame;
+  if (f == NULL) {
+    lock_release(&frame_lock);
+    return;
+  }
+
+  struct thread *t = thread_current();
+  if (t->pml4 != NULL) pml4_clear_page(t->pml4, page->va);
+
+  frame_unlink(f, page);
+  if (f->share_cnt == 0) frame_free(f);
+  lock_release(&frame_lock);
 }
 
 /* Growing the stack. */
 static void vm_stack_growth(void *addr UNUSED) {
   /** Project 3-Stack Growth*/
-  bool success = false;
+  /* 🆉 SPT 에 등록만 한다. 프레임은 폴트 처리부가 읽기/쓰기에 맞춰 결정한다 */
   addr = pg_round_down(addr);
   if (vm_alloc_page(VM_ANON | VM_MARKER_0, addr, true)) {
-    success = vm_claim_page(addr);
+    thread_current()->stack_bottom -= PGSIZE;
+  }
+}
 
-    if (success) {
-      thread_current()->stack_bottom -= PGSIZE;
-    }
+/* 🆉 한 번도 쓰이지 않아 내용이 전부 0 인 익명 페이지인가.
+ * 순수 익명(스택 등), read_bytes 가 0 인 bss, 0 페이지로 내려간 익명 페이지가 해당된다. */
+static bool page_is_zero_fill(struct page *page) {
+  if (page->operations->type == VM_UNINIT) {
+    struct uninit_page *u = &page->uninit;
+    if (VM_TYPE(u->type) != VM_ANON) return false;
+    if (u->init == NULL) return true;
+    return u->init == lazy_load_segment && ((struct lazy_aux *)u->aux)->read_bytes == 0;
   }
+  return page->operations->type == VM_ANON && page->anon.swap_slot == SWAP_SLOT_ZERO;
+}
+
+/* 🆉 PAGE 에 공유 zero 프레임을 읽기 전용으로 건다. 첫 쓰기에서 vm_handle_wp() 가
+ * 진짜 프레임을 잡는다. */
+static bool vm_map_zero_page(struct page *page) {
+  if (!pml4_set_page(thread_current()->pml4, page->va, zero_kva, false)) return false;
+  page->zero_mapped = true;
+  zero_map_cnt++;
+  return true;
 }
 
 /* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) { return false; }
+/* 🅲 COW: 공유 중인 프레임에 처음 쓰려는 순간 자기만의 사본을 만든다.
+ * 마지막 남은 공유자라면 복사 없이 쓰기 권한만 되돌려 준다. */
+static bool vm_handle_wp(struct page *page) {
+  struct thread *t = thread_current();
+
+  lock_acquire(&frame_lock);
+  frame_wait_stable(page);
+  struct frame *old = page->frame;
+  if (old == NULL) {
+    /* 🅿 폴트 직후 데몬이 내보냈다. 이제 혼자 쓰는 페이지이니 새로 올리면 된다 */
+    lock_release(&frame_lock);
+    return vm_do_claim_page(page);
+  }
+  struct frame *dst = old;
+  if (old->share_cnt > 1) {
+    /* 퇴출이 락을 놓는 동안 다른 공유자가 떠나도 old 가 나가지 않게 고정.
+     * 복사를 마치고 page 를 떼어 낼 때까지 풀지 않는다 */
+    old->pin_cnt++;
+    dst = vm_get_frame_locked();
+    if (dst == NULL) {
+      old->pin_cnt--;
+      lock_release(&frame_lock);
+      return false;
+    }
+    memcpy(dst->kva, old->kva, PGSIZE);
+    frame_unlink(old, page);
+    frame_link(dst, page);
+    old->pin_cnt--;
+  }
+
+  /* 읽기 전용 PTE 를 지우고(TLB 무효화 포함) 쓰기 가능으로 다시 건다.
+   * frame_lock 을 쥔 채로 걸어야 그 사이 퇴출이 dst 를 골라 재사용하지 못한다 */
+  pml4_clear_page(t->pml4, page->va);
+  bool ok = pml4_set_page(t->pml4, page->va, dst->kva, true);
+  if (dst != old) dst->pin_cnt--;
+  lock_release(&frame_lock);
+  return ok;
+}
 
 /** Project 3-Stack Growth*/
 #define STACK_LIMIT (USER_STACK - (1 << 20))
@@ -296,6 +647,7 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED, bool us
 
   /** Project 3-Anonymous Page */
   struct page *page = NULL;
+  fault_cnt++;
 
   if (addr == NULL || is_kernel_vaddr(addr))
     return false;
@@ -311,18 +663,27 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED, bool us
      * - addr이 최대 스택 크기(1MB) 제한인 STACK_LIMIT과 USER_STACK 사이의 유효한 범위에 있고,
      *   현재 스택 포인터 rsp보다 위쪽(높은 주소)에 있는 경우를 처리한다. (= 스택에 큰 버퍼를 잡고 접근할 때 발생할 경우를 처리)
      */
-    if (addr >= STACK_LIMIT && addr < USER_STACK && (addr >= rsp - 8)) {
+    page = spt_find_page(spt, addr);
+    if (page == NULL && addr >= STACK_LIMIT && addr < USER_STACK && (addr >= rsp - 8)) {
       vm_stack_growth(addr);
-      return true;
+      page = spt_find_page(spt, addr);
     }
-    page = spt_find_page(spt, addr);
 
     if (!page || (write && !page->writable))
       return false;
 
+    /* 🆉 읽기만 하는 0 페이지는 프레임 없이 공유 zero 프레임으로 */
+    if (!write && page->frame == NULL && page_is_zero_fill(page))
+      return vm_map_zero_page(page);
+
     return vm_do_claim_page(page);
   }
-  return false;
+
+  /* 🅲 present 인데 쓰기 위반: 쓰기 가능한 페이지라면 COW 공유 중인 것 */
+  if (!write) return false;
+  page = spt_find_page(spt, addr);
+  if (!page || !page->writable) return false;
+  return vm_handle_wp(page);
 }
 
 /* Free the page.
@@ -353,6 +714,19 @@ static bool vm_do_claim_page(struct page *page) {
   if (page == NULL) {
     return false;
   }
+  /* 🅿 데몬이 내보내는 중이었다면 기다린다. 실패해 매핑이 복구됐으면 그대로 쓴다 */
+  lock_acquire(&frame_lock);
+  frame_wait_stable(page);
+  bool resident = page->frame != NULL;
+  lock_release(&frame_lock);
+  if (resident) return true;
+
+  /* 🆉 zero 프레임이 걸려 있었다면 TLB 까지 지우고 진짜 프레임으로 바꾼다 */
+  if (page->zero_mapped) {
+    pml4_clear_page(thread_current()->pml4, page->va);
+    page->zero_mapped = false;
+  }
+
   /* 빈 프레임을 얻는다. */
   struct frame *frame = vm_get_frame();
   /* 프레임 할당에 실패한 경우 */
@@ -360,20 +734,27 @@ static bool vm_do_claim_page(struct page *page) {
     return false;
   }
   /* 페이지와 프레임을 서로 연결한다. */
-  frame->page = page;
-  page->frame = frame;
+  lock_acquire(&frame_lock);
+  frame_link(frame, page);
+  lock_release(&frame_lock);
   /* 페이지의 가상 주소(VA)를 프레임의 물리 주소(PA)에 매핑 */
   if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable)) {
     /* 자원은 할당받았지만 가상-물리 주소 매핑에 실패한 경우 */
-    /* 할당받았던 자원들을 모두 해제한다. */
-    palloc_free_page(frame->kva);
-    free(frame);
-    /* 페이지와 프레임의 연결을 끊어 댕글링 포인터를 방지한다. */
-    page->frame = NULL;
+    /* 페이지와 프레임의 연결을 끊고 프레임을 테이블에서 빼서 반납한다. */
+    lock_acquire(&frame_lock);
+    frame_unlink(frame, page);
+    frame_free(frame);
+    lock_release(&frame_lock);
     return false;
   }
   /* 페이지의 종류를 파악하고, 알맞은 위치에서 데이터를 읽어와 물리 프레임에 복사한다. */
-  return swap_in(page, frame->kva);
+  bool success = swap_in(page, frame->kva);
+
+  lock_acquire(&frame_lock);
+  frame->pin_cnt--;  // 🅵 내용이 채워졌으니 이제 퇴출 후보
+  pagein_cnt++;
+  lock_release(&frame_lock);
+  return success;
 }
 
 /* Initialize new supplemental page table */
@@ -382,6 +763,41 @@ void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
   hash_init(&spt->hash, page_hash, page_less, NULL);
 }
 
+/* 🅲 fork 때 이미 올라와 있는 SRC 페이지의 프레임을 DST 가 복사 없이 같이 쓰게 한다.
+ * 양쪽 PTE 를 읽기 전용으로 걸어 두고, 첫 쓰기에서 vm_handle_wp() 가 사본을 뜬다.
+ * 스왑으로 내려가 있으면 DST 도 같은 슬롯을 가리키게 한다.
+ * DST 는 현재(자식) 스레드의 SPT 에 있는 아직 uninit 인 페이지여야 한다. */
+static bool vm_share_page(struct page *dpage, struct page *spage, struct thread *parent) {
+  struct uninit_page *u = &dpage->uninit;
+
+  lock_acquire(&frame_lock);
+  frame_wait_stable(spage);
+  struct frame *f = spage->frame;
+  /* 프레임 없이 타입만 전환 (anon_initializer 는 kva 를 쓰지 않는다) */
+  if (!u->page_initializer(dpage, u->type, f != NULL ? f->kva : NULL)) {
+    lock_release(&frame_lock);
+    return false;
+  }
+  if (f == NULL) {
+    anon_swap_share(dpage, spage);
+    lock_release(&frame_lock);
+    return true;
+  }
+  frame_link(f, dpage);
+  /* 두 PTE 를 다 걸 때까지 f 가 퇴출되어 재사용되지 않게 고정 */
+  f->pin_cnt++;
+  lock_release(&frame_lock);
+
+  /* 부모는 fork_ready 에서 잠들어 있으므로 다시 돌 때 cr3 재적재로 TLB 가 비워진다 */
+  bool ok = (!spage->writable || pml4_set_page(parent->pml4, spage->va, f->kva, false)) &&
+            pml4_set_page(thread_current()->pml4, dpage->va, f->kva, false);
+
+  lock_acquire(&frame_lock);
+  f->pin_cnt--;
+  lock_release(&frame_lock);
+  return ok;
+}
+
 // /* Copy supplemental page table from src to dst */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
                                   struct supplemental_page_table *src UNUSED) {
@@ -399,12 +815,15 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
       struct uninit_page *u = &s_page->uninit;
 
       // 자식을 위한 lazy_aux 복사본 생성
-      struct lazy_aux *new_aux = malloc(sizeof(struct lazy_aux));
-      if (!new_aux) {
-        return false;
+      struct lazy_aux *new_aux = NULL;
+      if (u->aux != NULL) {  // 🆉 아직 안 쓰인 스택 페이지처럼 aux 가 없는 순수 익명 페이지도 있다
+        new_aux = malloc(sizeof(struct lazy_aux));
+        if (!new_aux) {
+          return false;
+        }
+        memcpy(new_aux, u->aux, sizeof(struct lazy_aux));
+        new_aux->file = file_reopen(new_aux->file);  // 자식만의 파일 핸들 생성
       }
-      memcpy(new_aux, u->aux, sizeof(struct lazy_aux));
-      new_aux->file = file_reopen(new_aux->file);  // 자식만의 파일 핸들 생성
 
       if (!vm_alloc_page_with_initializer(s_page->uninit.type, s_page->va, s_page->writable, u->init, new_aux)) {
         return false;
@@ -417,12 +836,7 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
       if (!dpage) {
         return false;
       }
-      if (s_page->frame) {
-        if (!vm_claim_page(dpage->va)) return false;
-        memcpy(dpage->frame->kva, s_page->frame->kva, PGSIZE);
-      } else {
-        // vm_claim_page(dpage->va); // claim을 하면 uninit이 아니므로 swap_in에서 문제가 발생할 수 있음
-      }
+      if (!vm_share_page(dpage, s_page, spt_owner(src))) return false;
     }
   }
   return true;